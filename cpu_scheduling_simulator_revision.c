@@ -1,457 +1,4155 @@
+// Build: gcc -O2 -pthread cpu_scheduling_simulator_revision.c -lm
+//        (add -mavx2 for the AVX2 selection kernel; x86-64 uses SSE2 otherwise)
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
 #include <limits.h>
+#include <math.h>
 #include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#ifndef INSTRUMENTATION
+#define INSTRUMENTATION 0       // -DINSTRUMENTATION=1 builds in hot-path counters and phase timers
+#endif
+#if INSTRUMENTATION && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
 
-#define MAX_PROCESSES 10
 #define TIME_QUANTUM 4
+#define NUM_ALGORITHMS 9
+#define MLFQ_MAX_LEVELS 8
+#define MLFQ_LEVELS 3               // default MLFQ: TIME_QUANTUM at the top, doubling per level
+#define MLFQ_BOOST_INTERVAL 100     // default MLFQ: every job returns to the top level this often
+#define NUM_LOAD_BALANCERS 3
+#define NUM_BENCH_DISTRIBUTIONS 4
+#define NUM_SWEEP_METRICS 5
+#define BENCH_MAX_PROCESSES 10000000     // --bench default: sizes 10, 100, ..., 10^7
+#define MAX_BURSTS 9                // CPU and I/O bursts per process: CPU, I/O, CPU, ..., CPU
+#define WORKLOAD_MAGIC "CPUWKLD1"
+#define WORKLOAD_VERSION 1
+#define RESULT_MAGIC "CPURSLT1"
+#define RESULT_VERSION 1
+#define RESULT_COLUMNS 6            // pid, arrival, burst, completion, waiting, turnaround
+#define RESULT_BATCH_ROWS 65536     // per-process rows a run buffers before writing a batch
+#define VERBOSITY_QUIET 0       // metrics and result files only
+#define VERBOSITY_SUMMARY 1     // per-algorithm averages, switch counts and utilization
+#define VERBOSITY_SCHEDULE 2    // Gantt charts
+#define VERBOSITY_PROCESS 3     // the workload and every process's waiting and turnaround time
+#ifndef MAX_VERBOSITY
+#define MAX_VERBOSITY VERBOSITY_PROCESS     // -DMAX_VERBOSITY=0 compiles every report out
+#endif
+#define SCAN_SELECT_LIMIT 64    // in-memory workloads up to this size select by scanning
+#define SWITCH_PID INT_MIN      // timeline segments a CPU spends switching between processes
+#define CHECKPOINT_SPACING 4096 // dispatches between checkpoints, plus one per entry saved
+#define HISTOGRAM_SUB_BUCKETS 128               // buckets per power of two: values kept within 1/128
+#define HISTOGRAM_SIZE (57 * HISTOGRAM_SUB_BUCKETS) // buckets for any non-negative long long
+#define NUM_LATENCY_METRICS 5
+#define NUM_PERCENTILES 4
+#define SLOWDOWN_SCALE 100      // slowdown is recorded in hundredths
+#define STRIDE_ONE (1 << 20)    // stride scheduling: pass a one-ticket process advances per time unit
+#define TRACE_BUFFER_SIZE (1 << 16) // bytes of Chrome trace events a run buffers before writing them
+#define TRACE_JOBS_LANE -1      // Chrome trace thread of arrivals and completions; CPU lanes follow it
+
+// Reports at a level above MAX_VERBOSITY are constant-false and compile away; the rest depend on
+// the verbosity chosen at run time
+#define VERBOSE(verbosity, level) ((level) <= MAX_VERBOSITY && (verbosity) >= (level))
+#define REPORTS(ctx, level) (VERBOSE((ctx)->verbosity, level) && (ctx)->out != NULL)
+
+// Instrumentation hooks. TIMED runs a statement and charges its cycles to a phase; COUNT adds to
+// a counter, COUNT_QUEUE to the counters of the run a queue belongs to. Without INSTRUMENTATION
+// TIMED is the bare statement and the counters are never touched.
+#if INSTRUMENTATION
+#define TIMED(stats, phase, statement) do { \
+        uint64_t phase_start = read_cycles(); \
+        statement; \
+        (stats)->phase_cycles[phase] += read_cycles() - phase_start; \
+        (stats)->phase_calls[phase]++; \
+    } while (0)
+#define COUNT(stats, counter, n) ((stats)->counter += (n))
+#define COUNT_QUEUE(queue, counter, n) do { if ((queue)->stats != NULL) (queue)->stats->counter += (n); } while (0)
+#else
+#define TIMED(stats, phase, statement) statement
+#define COUNT(stats, counter, n) ((void)0)
+#define COUNT_QUEUE(queue, counter, n) ((void)0)
+#endif
 
 typedef struct {
     int pid;
     int arrival_time;
     int burst_time;
-    int remaining_time;
     int priority;
-    int waiting_time;
-    int turnaround_time;
-    int completion_time;
-    bool completed;
+    int num_bursts;             // 0 means one CPU burst of burst_time
+    int bursts[MAX_BURSTS];     // alternating CPU and I/O bursts, starting and ending with CPU
 } Process;
 
-int compare_arrival_time(const void* a, const void* b);
-void enqueue(int queue[], int* rear, int value);
-int dequeue(int queue[], int* front);
+// Structure-of-arrays process table used by the engine. The fields read on every scheduling
+// decision live in their own contiguous arrays and completion is a bitset, so selection touches
+// only the bytes it compares; the result fields written once per process are kept apart.
+// Process remains the record type for generating, printing and loading workloads.
+typedef struct {
+    // hot: read while selecting the next process
+    int* pid;
+    int* arrival_time;
+    int* burst_time;
+    int* remaining_time;
+    int* priority;
+    uint64_t* completed;
+    int* ready_time;    // when the process last entered the ready queue
+    long long* pass;    // stride scheduling: virtual time of the next dispatch
+    int* age_origin;    // aging: aging epoch its wait counts from, moved on by the epochs it ran
+    int* level;         // MLFQ level, 0 is the top
+    int* next_ready;    // MLFQ level lists
+    int* last_cpu;      // SMP: CPU the process last ran on, -1 if it has not run
+    int* phase;             // index of the current burst; odd while blocked on I/O
+    int* phase_remaining;   // CPU time left in the current burst
+    // cold: burst sequences and results
+    int* num_bursts;
+    int* bursts;            // MAX_BURSTS entries per process
+    int* blocked_time;      // time spent waiting for and doing I/O
+    int* response_time;     // arrival to first dispatch, -1 until dispatched
+    int* longest_wait;      // longest stretch in the ready queue so far
+    int* waiting_time;
+    int* turnaround_time;
+    int* completion_time;
+} ProcessTable;
+
+// Ordering key used to pick the next process from the ready set
+typedef enum {
+    SELECT_ARRIVAL,     // FCFS, Round Robin
+    SELECT_BURST,       // Non-Preemptive SJF
+    SELECT_REMAINING,   // Preemptive SJF (SRTF)
+    SELECT_PRIORITY,    // Priority (larger value runs first)
+    SELECT_LEVEL,       // MLFQ (FIFO per level, top level first)
+    SELECT_RESPONSE_RATIO,  // HRRN (largest (waiting + burst) / burst first)
+    SELECT_PASS,        // Stride (smallest pass first, priority is the ticket count)
+    SELECT_AGED_PRIORITY,   // Preemptive Priority with aging
+    SELECT_AGED_REMAINING,  // Preemptive SJF (SRTF) with aging
+    SELECT_IO_BURST     // I/O device, shortest request first
+} SelectKey;
+
+// Multi-level feedback queue. New jobs enter level 0; a job that uses its whole quantum moves
+// down one level, and every boost_interval time units all jobs return to level 0. A job below
+// the top level is preempted by a job that becomes ready at a higher level, and keeps its level.
+typedef struct {
+    int num_levels;                 // 1..MLFQ_MAX_LEVELS
+    int quanta[MLFQ_MAX_LEVELS];    // quantum of each level, > 0
+    int boost_interval;             // 0 disables the boost
+} MlfqConfig;
+
+// Scheduling policy run by the shared engine: the ready-queue key that selects the next process,
+// the preemption rule and the quantum. Fixed policies are defined with DEFINE_POLICY.
+typedef struct {
+    SelectKey key;
+    bool preemptive;    // re-select whenever a new process arrives
+    int time_quantum;   // > 0 limits each dispatch to one quantum (round robin)
+    const MlfqConfig* mlfq;     // SELECT_LEVEL only
+} SchedulerConfig;
+
+typedef struct {
+    int arrival_time;
+    int index;
+} ArrivalEntry;
+
+// Phases of a run that instrumented builds time separately
+typedef enum {
+    PHASE_ENGINE,       // the whole simulation, including the three phases below
+    PHASE_ADMIT,        // admitting arrivals (reading streamed traces) and I/O returns
+    PHASE_SELECT,       // picking the next process
+    PHASE_TIMELINE,     // timeline writes
+    PHASE_REPORT,       // formatting the report
+    PHASE_EXPORT,       // buffering per-process results
+    NUM_PHASES
+} Phase;
+
+// Hot-path counters and per-phase cycle totals of one context's runs (INSTRUMENTATION only)
+typedef struct {
+    long long decisions;        // dispatches
+    long long candidates;       // processes examined to pick them
+    long long preemptions;      // slices that sent an unfinished CPU burst back to the ready queue
+    long long enqueues;         // ready, run and device queue operations
+    long long dequeues;
+    long long timeline_writes;
+    uint64_t phase_cycles[NUM_PHASES];
+    long long phase_calls[NUM_PHASES];
+} Instrumentation;
+
+// Kinetic tournament over the items of a SELECT_RESPONSE_RATIO queue. A response ratio grows
+// linearly with time, so the order of two processes changes at most once; each internal node k
+// (1 <= k < size) keeps the item position that won below it and the earliest time that win, or
+// one below it, can be overturned. Leaf p is node size + p. A dequeue replays only the expired
+// nodes, and an enqueue or removal replays the leaf's path, O(log n) each.
+typedef struct {
+    int* winner;        // item position, -1 for an empty subtree
+    int* expires;
+    int size;           // leaves, a power of two
+} Tournament;
+
+// Aged heap keys. A waiting process gains one priority level (or one unit off its remaining time)
+// at every multiple of the aging interval, so at time t its effective priority is
+// priority + t / interval - age_origin. The t term is common to every waiting process, so the
+// order never changes while they wait and the heap needs no rescan as they age.
+#define AGED_PRIORITY_KEY(table, i) ((long long)(table)->priority[i] - (table)->age_origin[i])
+#define AGED_REMAINING_KEY(table, i) ((long long)(table)->remaining_time[i] + (table)->age_origin[i])
+
+// Ready queue holding process indices. SELECT_ARRIVAL uses a circular FIFO (processes are
+// admitted in arrival order); every other key uses a binary min-heap ordered by the key, with
+// ties broken by pid. A process is in the queue at most once, so capacity >= live processes.
+// SELECT_LEVEL keeps one FIFO per MLFQ level, linked through the table's next_ready.
+// SELECT_RESPONSE_RATIO keeps the items unordered and picks from them with a Tournament.
+// In scan mode (small in-memory workloads whose pids ascend with their index) there is no heap:
+// the ready set is every process that has arrived by scan_limit and is not completed, and
+// dequeue picks from it with select_process.
+typedef struct {
+    int* items;
+    int capacity;
+    int front;          // FIFO only
+    int count;
+    SelectKey key;
+    ProcessTable* table;
+    int num_levels;     // SELECT_LEVEL only
+    int level_head[MLFQ_MAX_LEVELS];
+    int level_tail[MLFQ_MAX_LEVELS];
+    bool scan;
+    int scan_size;      // scan mode: table entries to scan
+    int scan_limit;     // scan mode: latest admitted arrival time
+    Instrumentation* stats;     // counters of the run the queue belongs to, NULL for none
+    Tournament* tournament;     // SELECT_RESPONSE_RATIO only, kept by the run across dequeues
+    int now;            // SELECT_RESPONSE_RATIO: time of the next dequeue, set by the engine
+    long long pass;     // SELECT_PASS: pass of the last process dequeued, where joining ones start
+} ReadyQueue;
+
+// One run of a process on the CPU, [start, end). Consecutive runs of the same process are merged,
+// so the timeline grows with the number of context switches rather than with total CPU time.
+typedef struct {
+    int pid;
+    int start;
+    int end;
+} TimelineSegment;
+
+typedef struct {
+    TimelineSegment* segments;
+    int size;
+    int capacity;
+} Timeline;
+
+// Last process a CPU ran and when it stopped, to tell a context switch from a process that keeps
+// the CPU
+typedef struct {
+    bool ran;
+    int pid;
+    int end;
+} DispatchHistory;
+
+// One simulated CPU in SMP mode: its run queue (with its own item buffer), the slice it is
+// running, its Gantt lane and its counters.
+typedef struct {
+    ReadyQueue queue;
+    int running;            // process index, -1 when idle
+    int dispatch_time;
+    int run_start;          // dispatch_time plus switch overhead and any migration cost
+    int overhead;           // switch overhead of the current dispatch
+    int slice_end;
+    int quantum;            // what is left of the quantum, 0 for none
+    bool cut;               // a process that became ready ended the slice early
+    int preempted;          // process whose slice went back to the queue, -1 once the next dispatch is made
+    Timeline timeline;
+    Tournament tournament;
+    DispatchHistory history;
+    long long busy_time;
+    long long migrations;
+    long long migration_time;
+} CpuState;
+
+// Simulated I/O device. Blocked processes queue for it under its own discipline (FIFO or
+// SELECT_IO_BURST) and are served one at a time.
+typedef struct {
+    ReadyQueue queue;
+    int serving;            // process index, -1 when idle
+    int busy_until;
+    long long busy_time;
+} IoDevice;
+
+// SMP load-balancing policy: where a new arrival is queued, and which CPU an idle CPU with an
+// empty queue steals from (-1 for none; a NULL steal never steals).
+typedef struct {
+    const char* name;
+    int (*place)(const CpuState cpus[], int num_cpus, const ProcessTable* table, int idx);
+    int (*steal)(const CpuState cpus[], int num_cpus, int thief);
+} LoadBalancer;
+
+typedef struct {
+    int num_cpus;
+    int migration_cost;     // time a process spends on a CPU before running after moving there
+    const LoadBalancer* balancer;
+} SmpConfig;
+
+// Streaming reader for CSV job traces, one job per line: arrival,burst,priority followed by
+// either one io_burst (split around the middle of the CPU burst) or io,burst pairs.
+// Lines must be sorted by arrival time. The next job is read ahead so the engine can see when it
+// arrives without admitting it early.
+typedef struct {
+    FILE* fp;
+    const char* filename;
+    char* line;
+    size_t line_capacity;
+    long line_number;
+    int next_pid;
+    int last_arrival;
+    bool past_header;           // a job or header line has been read
+    bool has_pending;
+    bool failed;
+    bool quiet;                 // fail without printing the error
+    Process pending;
+} TraceReader;
+
+// Binary workload file: a WorkloadHeader followed by num_records fixed-width records in native
+// (little-endian) byte order, sorted by arrival time. The records mirror the input fields of Process.
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t num_records;
+} WorkloadHeader;
+
+typedef struct {
+    int32_t pid;
+    int32_t arrival_time;
+    int32_t burst_time;
+    int32_t priority;
+    int32_t io_burst_time;
+} WorkloadRecord;
+
+// A binary workload mapped read-only; records point straight into the mapping
+typedef struct {
+    void* base;
+    size_t length;
+    const WorkloadRecord* records;
+    long long num_records;
+} MappedWorkload;
+
+// Which per-process results the runs keep besides the per-algorithm averages
+typedef enum {
+    RESULTS_NONE,
+    RESULTS_CSV,        // process_results.csv, one row per process
+    RESULTS_BINARY      // process_results.bin, columnar batches
+} ResultFormat;
+
+// Per-process latency distributions of a run
+typedef enum {
+    METRIC_WAITING,
+    METRIC_TURNAROUND,
+    METRIC_RESPONSE,
+    METRIC_SLOWDOWN,    // turnaround time over CPU burst time, in 1/SLOWDOWN_SCALE units
+    METRIC_LONGEST_WAIT // longest single stretch in the ready queue
+} LatencyMetric;
+
+// Log-linear (HDR-style) histogram of non-negative values: exact below 2 * HISTOGRAM_SUB_BUCKETS,
+// then HISTOGRAM_SUB_BUCKETS buckets per power of two, so a percentile is off by less than 1%
+// and memory stays fixed however many samples are recorded.
+typedef struct {
+    long long* counts;
+    int num_buckets;        // allocated buckets, grown to cover the largest value recorded
+    long long count;
+    long long total;
+    long long max;
+} Histogram;
+
+// Per-process results of one run, buffered column by column. A full batch is encoded in the
+// output format and appended to the run's spill file, so memory stays bounded however many
+// processes complete; write_results copies the batches out once every run has finished.
+typedef struct {
+    int32_t* columns[RESULT_COLUMNS];
+    int count;
+    int capacity;
+    long long num_rows;     // including spilled batches
+    long long num_batches;  // spilled batches
+    FILE* spill;
+} ResultBuffer;
+
+// Binary per-process results: a ResultFileHeader, then per algorithm a ResultSectionHeader and
+// num_batches batches. A batch is a uint32_t row count n followed by RESULT_COLUMNS int32_t
+// columns of n values each, in ResultBuffer column order.
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_sections;
+} ResultFileHeader;
+
+typedef struct {
+    char algorithm[32];
+    uint64_t num_rows;
+    uint64_t num_batches;
+} ResultSectionHeader;
+
+// State of one live (admitted, unfinished) process at a checkpoint
+typedef struct {
+    int idx;
+    int remaining_time;
+    int phase;
+    int phase_remaining;
+    int level;
+    int next_ready;
+    int blocked_time;
+    int response_time;
+    int ready_time;
+    long long pass;
+    int age_origin;
+    int longest_wait;
+} LiveProcess;
+
+// Engine state at the top of the single-CPU loop, where no process is running. Everything the
+// rest of the run depends on is here or in the table entries of processes not yet admitted, so
+// a run resumed from it schedules exactly like the original run from that point on.
+// Queue contents are saved front first (heap: array order); the item pointers in queue and
+// device are stale.
+typedef struct {
+    int current_time;
+    int next_boost;
+    DispatchHistory history;
+    int num_admitted;           // arrivals taken from the arrival-sorted index
+    ReadyQueue queue;
+    IoDevice device;
+    int* queue_items;
+    int* device_items;
+    LiveProcess* live;
+    int num_live;
+    long long dispatches;       // at the checkpoint
+    long long num_completed;
+    long long total_waiting_time;
+    long long total_turnaround_time;
+    long long cpu_busy_time;
+    long long io_requests;
+    long long context_switches;
+    long long switch_overhead;
+    Histogram latency[NUM_LATENCY_METRICS];
+    int timeline_size;
+    int timeline_end;           // end of the last segment, which may have been extended since
+} Checkpoint;
+
+// Chrome Trace Event output of one run. Events are written as the engine produces them, through a
+// TRACE_BUFFER_SIZE stdio buffer into a temp file, so memory stays bounded however long the
+// schedule is; write_chrome_trace joins the runs' files in algorithm order. Each CPU lane holds
+// back its last run segment so consecutive runs of a process merge as they do in the timeline.
+typedef struct {
+    FILE* events;
+    TimelineSegment* pending;   // per lane, end < 0 when there is none
+    int num_lanes;
+    int lane_capacity;
+} TraceExport;
+
+// Storage owned by one algorithm run: its own copy of the workload, scratch arrays and timeline.
+// Buffers grow on demand. Every algorithm gets its own context so the runs can proceed in parallel.
+// When trace_filename or workload_map is set the process table is a pool of live jobs instead:
+// completed slots are recycled and no timeline is kept, so memory stays bounded by live jobs.
+typedef struct {
+    ProcessTable processes;
+    int num_processes;
+    int process_capacity;
+    ArrivalEntry* arrivals;     // scratch for run_simulation, process_capacity entries
+    int* ready_items;           // scratch for the ready queue, process_capacity entries
+    Tournament tournament;      // HRRN ready queue
+    int* free_slots;            // recycled process slots (trace runs only)
+    int num_free_slots;
+    Timeline timeline;
+    const SmpConfig* smp;       // simulate several CPUs, NULL for one
+    CpuState* cpus;             // SMP only: per-CPU run queues, Gantt lanes and counters
+    int num_cpus;
+    int makespan;               // time the last process finished
+    long long cpu_busy_time;    // single CPU; SMP keeps it per CPU
+    IoDevice device;
+    SelectKey io_discipline;    // SELECT_ARRIVAL (FIFO) or SELECT_IO_BURST
+    long long io_requests;
+    int dispatch_latency;       // charged whenever a CPU starts running a process
+    int switch_cost;            // charged on top when a different process ran there last
+    int aging_interval;         // > 0: preemptive priority and SRTF age waiting processes every this often
+    long long dispatches;
+    long long context_switches;
+    long long switch_overhead;  // CPU time spent dispatching and switching
+    const char* trace_filename; // stream the workload from this CSV trace instead of processes[]
+    const MappedWorkload* workload_map; // or from this mapped binary workload (shared, read-only)
+    bool trace_failed;
+    bool quiet_trace_errors;    // another run over the same trace reports its errors
+    FILE* out;                  // report output for this run, NULL for none
+    int verbosity;              // VERBOSITY_* level of the report
+    ResultFormat result_format;
+    ResultBuffer results;
+    bool checkpointing;         // single-CPU in-memory runs: save checkpoints as the run goes
+    Checkpoint* checkpoints;    // in time order
+    int num_checkpoints;
+    int checkpoint_capacity;
+    Checkpoint* resume;         // start the next run from this checkpoint instead of t=0
+    int trace_process;          // > 0: export the schedule as this Chrome trace process
+    TraceExport trace_export;
+    const char* algorithm_name;
+    long long num_completed;
+    long long total_waiting_time;
+    long long total_turnaround_time;
+    Histogram latency[NUM_LATENCY_METRICS];
+    double avg_waiting_time;
+    double avg_turnaround_time;
+    Instrumentation stats;
+} SimulationContext;
+
+// A scheduling algorithm and the name its runs report under
+typedef struct {
+    void (*run)(SimulationContext* ctx);
+    const char* name;
+} Algorithm;
+
+// Where run_simulation takes new processes from: the arrival-sorted index of an in-memory
+// workload, or a CSV trace / mapped binary workload read lazily as simulated time reaches
+// each arrival.
+typedef struct {
+    ArrivalEntry* arrivals;
+    int num_arrivals;
+    int next_arrival;
+    TraceReader* reader;
+    const MappedWorkload* map;
+    long long next_record;
+    int last_arrival;
+    bool failed;
+    bool quiet;
+} ArrivalSource;
+
+// Command-line options that apply to every algorithm's run
+typedef struct {
+    const SmpConfig* smp;       // NULL for one CPU
+    bool with_io;               // generated workloads get an I/O burst
+    SelectKey io_discipline;
+    int dispatch_latency;
+    int switch_cost;
+    int aging_interval;
+    ResultFormat result_format;
+    int verbosity;
+    const char* chrome_trace;   // Chrome Trace Event file of every algorithm's schedule, NULL for none
+} SimulationOptions;
+
+// Monte Carlo sweep: per-trial values of each metric are stored as [trial * NUM_ALGORITHMS + algorithm]
+typedef struct {
+    int num_trials;
+    int num_processes;
+    uint64_t seed;
+    double* samples[NUM_SWEEP_METRICS];
+    const SimulationOptions* options;
+} SweepState;
+
+// What-if queries: per algorithm, one checkpointed run of the base trace, then every edited trace
+// resumed from the last checkpoint its edit leaves valid
+typedef struct {
+    const Process* base;
+    int num_base;
+    const Process* edited;  // the current query
+    int num_edited;
+    int first_changed;      // first job that differs, or the shorter length
+    int change_time;        // earliest arrival of that job in either trace, INT_MAX for none
+    SimulationContext* contexts;
+    int replaced_from[NUM_ALGORITHMS];  // first table entry an earlier query overwrote
+    double base_waiting_times[NUM_ALGORITHMS];
+    double base_turnaround_times[NUM_ALGORITHMS];
+    double base_seconds[NUM_ALGORITHMS];
+    double replay_seconds[NUM_ALGORITHMS];
+    int resume_times[NUM_ALGORITHMS];
+} WhatIfState;
+
+// Benchmark workload shape: draws the gap to the next arrival and the job's CPU burst
+typedef struct {
+    const char* name;
+    void (*next_job)(uint64_t* state, long long index, int* interarrival, int* burst);
+} BenchDistribution;
+
+typedef struct {
+    double mean;
+    double stddev;
+    double p50;
+    double p90;
+    double p99;
+} SampleSummary;
+
+// Fixed set of tasks handed out to worker threads in index order
+typedef struct {
+    void (*task)(void* arg, int index);
+    void* arg;
+    int num_tasks;
+    int next_task;
+    pthread_mutex_t lock;
+} TaskPool;
+
+int compare_arrival_entry(const void* a, const void* b);
+void enqueue(ReadyQueue* queue, int value);
+int dequeue(ReadyQueue* queue);
+bool ready_queue_displaces(ReadyQueue* queue, int idx);
+void boost_levels(ReadyQueue* queue);
+void init_ready_queue(ReadyQueue* queue, int* items, int capacity, const SchedulerConfig* config, ProcessTable* table);
+void resize_ready_queue(ReadyQueue* queue, int* items, int capacity);
+void rebuild_tournament(ReadyQueue* queue, int size);
+void update_tournament(ReadyQueue* queue, int position);
+void refresh_tournament(ReadyQueue* queue, int node);
+void settle_tournament_node(ReadyQueue* queue, int node);
+int overtake_time(const ProcessTable* table, int winner, int loser);
+int select_process(const ProcessTable* table, int num_processes, int arrival_limit, SelectKey key);
 
 // Function prototypes
-void generate_processes(Process processes[], int num_processes);
+void* grow_array(void* items, int capacity, size_t item_size);
+void reserve_processes(SimulationContext* ctx, int num_processes);
+bool is_completed(const ProcessTable* table, int idx);
+void set_completed(ProcessTable* table, int idx, bool completed);
+void store_process(ProcessTable* table, int idx, const Process* process);
+void load_workload(SimulationContext* ctx, const Process workload[], int num_processes);
+void append_timeline(Timeline* timeline, int pid, int start, int end);
+void record_segment(SimulationContext* ctx, Timeline* timeline, bool keep_timeline, int lane, int pid, int start, int end);
+void start_trace_export(SimulationContext* ctx, int num_lanes);
+void trace_run(SimulationContext* ctx, int lane, int pid, int start, int end);
+void write_trace_segment(SimulationContext* ctx, int lane, const TimelineSegment* segment);
+void trace_instant(SimulationContext* ctx, int lane, const char* name, int pid, int time);
+void finish_trace_export(SimulationContext* ctx);
+int write_chrome_trace(const char* filename, SimulationContext contexts[], int num_contexts);
+void free_simulation_context(SimulationContext* ctx);
+void apply_options(SimulationContext* ctx, const SimulationOptions* options);
+uint64_t next_random(uint64_t* state);
+void generate_processes(Process processes[], int num_processes, uint64_t seed, bool with_io);
+void split_io_burst(Process* process, int io_burst_time);
 void print_processes(Process processes[], int num_processes);
-void calculate_average_times(Process processes[], int num_processes, float* avg_waiting_time, float* avg_turnaround_time);
-void export_averages_to_csv(const char* filename, const char* algorithm_name, float avg_waiting_time, float avg_turnaround_time);
-void fcfs_scheduling(Process processes[], int num_processes);
-void non_preemptive_sjf(Process processes[], int num_processes);
-void preemptive_sjf(Process processes[], int num_processes);
-void non_preemptive_priority(Process processes[], int num_processes);
-void preemptive_priority(Process processes[], int num_processes);
-void round_robin(Process processes[], int num_processes, int time_quantum);
-void reset_processes(Process processes[], int num_processes);
-void print_gantt_chart(Process processes[], int num_processes, int timeline[], int timeline_size, int time_stamps[]);
-
-// 도착 시간을 기준으로 정렬하기 위한 비교 함수
-int compare_arrival_time(const void* a, const void* b) {
-    const Process* pa = (const Process*)a;
-    const Process* pb = (const Process*)b;
-
-    if (pa->arrival_time < pb->arrival_time) return -1;
-    if (pa->arrival_time > pb->arrival_time) return 1;
+int histogram_bucket(long long value);
+long long histogram_bucket_value(int bucket);
+void reserve_buckets(Histogram* histogram, int num_buckets);
+void record_histogram(Histogram* histogram, long long value);
+long long histogram_percentile(const Histogram* histogram, double percentile);
+double histogram_mean(const Histogram* histogram);
+void copy_histogram(Histogram* to, const Histogram* from);
+double latency_value(int metric, double value);
+void calculate_average_times(SimulationContext* ctx);
+void record_result(SimulationContext* ctx, int idx);
+void write_result_batch(FILE* fp, const SimulationContext* ctx);
+void spill_results(SimulationContext* ctx);
+void reset_results(ResultBuffer* results);
+bool copy_file(FILE* from, FILE* to);
+void write_summary_header(FILE* fp);
+void write_summary_row(FILE* fp, const SimulationContext* ctx);
+int write_results(SimulationContext contexts[], int num_contexts, ResultFormat format);
+int write_process_results(SimulationContext contexts[], int num_contexts, ResultFormat format);
+void run_policy(SimulationContext* ctx, const SchedulerConfig* config);
+void fcfs_scheduling(SimulationContext* ctx);
+void non_preemptive_sjf(SimulationContext* ctx);
+void preemptive_sjf(SimulationContext* ctx);
+void non_preemptive_priority(SimulationContext* ctx);
+void preemptive_priority(SimulationContext* ctx);
+void round_robin(SimulationContext* ctx, int time_quantum);
+void round_robin_default(SimulationContext* ctx);
+void mlfq_scheduling(SimulationContext* ctx, const MlfqConfig* mlfq);
+void mlfq_default(SimulationContext* ctx);
+void hrrn_scheduling(SimulationContext* ctx);
+void stride_scheduling(SimulationContext* ctx);
+bool open_trace(TraceReader* reader, const char* filename, bool quiet);
+void close_trace(TraceReader* reader);
+bool trace_peek(TraceReader* reader);
+bool is_workload_file(const char* filename);
+bool map_workload(MappedWorkload* workload, const char* filename);
+void unmap_workload(MappedWorkload* workload);
+int write_workload(const char* filename, long long num_records, uint64_t seed);
+void unpack_record(const WorkloadRecord* record, Process* process);
+Process* read_workload(const char* filename, int* num_processes);
+int next_arrival_time(ArrivalSource* source);
+int acquire_process_slot(SimulationContext* ctx, ReadyQueue* queue);
+int take_arrival(SimulationContext* ctx, ArrivalSource* source, ReadyQueue* queue);
+void admit_arrivals(SimulationContext* ctx, ArrivalSource* source, int current_time, ReadyQueue* queue);
+void admit_ready(SimulationContext* ctx, ArrivalSource* source, int current_time, ReadyQueue* queue);
+bool open_arrival_source(SimulationContext* ctx, ArrivalSource* source, TraceReader* reader);
+void close_arrival_source(SimulationContext* ctx, ArrivalSource* source);
+void complete_process(SimulationContext* ctx, int idx, int current_time, bool streaming);
+int dispatch_quantum(const SchedulerConfig* config, const ProcessTable* table, int idx);
+bool preempts_on_arrival(const SchedulerConfig* config, const ProcessTable* table, int running, int ready);
+void end_slice(const SchedulerConfig* config, ProcessTable* table, int idx, int exec_time, int quantum);
+int process_stride(const ProcessTable* table, int idx);
+void start_io(SimulationContext* ctx, int idx, int current_time);
+int next_io_return(SimulationContext* ctx, int current_time);
+int next_ready_time(ArrivalSource* source, const IoDevice* device);
+double total_cpu_utilization(const SimulationContext* ctx);
+double device_utilization(const SimulationContext* ctx);
+void start_dispatch(ProcessTable* table, int idx, int current_time);
+void requeue_process(SimulationContext* ctx, int idx, int dispatch_time, int current_time);
+int aging_overtake_time(const SimulationContext* ctx, const ReadyQueue* queue, int idx, int dispatch_time, int run_start);
+int smp_slice_end(const SimulationContext* ctx, const CpuState* cpu, int idx, int next_boost);
+int first_boost_time(const SchedulerConfig* config);
+int dispatch_overhead(SimulationContext* ctx, DispatchHistory* history, int pid, int current_time);
+void save_live(Checkpoint* checkpoint, const ProcessTable* table, int idx);
+int save_checkpoint(SimulationContext* ctx, const ReadyQueue* queue, const ArrivalSource* source, int current_time, int next_boost, const DispatchHistory* history);
+void restore_checkpoint(SimulationContext* ctx, const Checkpoint* checkpoint, ReadyQueue* queue, ArrivalSource* source);
+void run_simulation(SimulationContext* ctx, const SchedulerConfig* config);
+void run_smp_simulation(SimulationContext* ctx, const SchedulerConfig* config);
+void place_ready(SimulationContext* ctx, ArrivalSource* source, const SchedulerConfig* config, int current_time);
+void enqueue_growing(ReadyQueue* queue, int idx);
+int place_least_loaded(const CpuState cpus[], int num_cpus, const ProcessTable* table, int idx);
+int place_by_pid(const CpuState cpus[], int num_cpus, const ProcessTable* table, int idx);
+int steal_busiest(const CpuState cpus[], int num_cpus, int thief);
+const LoadBalancer* find_load_balancer(const char* name);
+double cpu_utilization(const SimulationContext* ctx, int cpu);
+void print_schedule(SimulationContext* ctx);
+void print_gantt_cell(FILE* out, const char* label, int start, bool stamp_row);
+void print_gantt_chart(FILE* out, const char* title, TimelineSegment timeline[], int timeline_size);
+int default_thread_count(void);
+void* task_pool_worker(void* arg);
+void run_parallel(int num_tasks, int num_threads, void (*task)(void* arg, int index), void* arg);
+void run_algorithm(SimulationContext* ctx, int index);
+void run_algorithm_task(void* arg, int index);
+int compare_double(const void* a, const void* b);
+void summarize_samples(double samples[], int count, SampleSummary* summary);
+void run_sweep_trial(void* arg, int trial);
+int run_sweep(int num_trials, int num_processes, uint64_t seed, const SimulationOptions* options);
+int run_trace(const char* filename, const SimulationOptions* options);
+bool same_job(const Process* a, const Process* b);
+void run_what_if_base_task(void* arg, int index);
+void run_what_if_task(void* arg, int index);
+int run_what_if(const char* base_filename, char* const edited_filenames[], int num_edited_files, const SimulationOptions* options);
+double random_unit(uint64_t* state);
+void bench_uniform(uint64_t* state, long long index, int* interarrival, int* burst);
+void bench_exponential(uint64_t* state, long long index, int* interarrival, int* burst);
+void bench_heavy_tail(uint64_t* state, long long index, int* interarrival, int* burst);
+void bench_batches(uint64_t* state, long long index, int* interarrival, int* burst);
+void generate_records(WorkloadRecord records[], long long num_records, uint64_t seed, const BenchDistribution* distribution);
+double elapsed_seconds(const struct timespec* start);
+void reset_peak_rss(void);
+long peak_rss_kb(void);
+int run_benchmark(long long max_processes, uint64_t seed, const SimulationOptions* options);
+#if INSTRUMENTATION
+uint64_t read_cycles(void);
+int write_instrumentation(const SimulationContext contexts[], int num_contexts, uint64_t export_cycles);
+#endif
+
+// 도착 시간, 같으면 인덱스 순으로 정렬하기 위한 비교 함수
+int compare_arrival_entry(const void* a, const void* b) {
+    const ArrivalEntry* ea = (const ArrivalEntry*)a;
+    const ArrivalEntry* eb = (const ArrivalEntry*)b;
+
+    if (ea->arrival_time < eb->arrival_time) return -1;
+    if (ea->arrival_time > eb->arrival_time) return 1;
+    if (ea->index < eb->index) return -1;
+    if (ea->index > eb->index) return 1;
     return 0;
 }
 
-void generate_processes(Process processes[], int num_processes) {
-    srand(time(NULL));
+// splitmix64: 호출하는 쪽이 상태를 가지므로 스레드마다 독립적이고 시드로 재현 가능하다
+uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void generate_processes(Process processes[], int num_processes, uint64_t seed, bool with_io) {
+    uint64_t state = seed;
     for (int i = 0; i < num_processes; i++) {
         processes[i].pid = i + 1;
-        processes[i].arrival_time = rand() % 10;
-        processes[i].burst_time = rand() % 10 + 1;
-        processes[i].remaining_time = processes[i].burst_time;
-        processes[i].priority = rand() % 10 + 1;
-        processes[i].waiting_time = 0;
-        processes[i].turnaround_time = 0;
-        processes[i].completion_time = 0;
-        processes[i].completed = false;
+        processes[i].arrival_time = (int)(next_random(&state) % 10);
+        processes[i].burst_time = (int)(next_random(&state) % 10) + 1;
+        processes[i].priority = (int)(next_random(&state) % 10) + 1;
+        processes[i].num_bursts = 0;
+        if (with_io) {
+            split_io_burst(&processes[i], (int)(next_random(&state) % 5) + 1);
+        }
     }
 }
 
-void print_processes(Process processes[], int num_processes) {
-    printf("PID\tArrival\tBurst\tPriority\n");
-    for (int i = 0; i < num_processes; i++) {
-        printf("%d\t%d\t%d\t%d\n", processes[i].pid, processes[i].arrival_time, processes[i].burst_time, processes[i].priority);
+// One I/O of io_burst_time in the middle of the CPU burst (the binary format's io_burst_time).
+// A process with a one-unit CPU burst has no room for I/O and keeps a single burst.
+void split_io_burst(Process* process, int io_burst_time) {
+    process->num_bursts = 0;
+    if (io_burst_time > 0 && process->burst_time >= 2) {
+        process->num_bursts = 3;
+        process->bursts[0] = (process->burst_time + 1) / 2;
+        process->bursts[1] = io_burst_time;
+        process->bursts[2] = process->burst_time / 2;
     }
 }
 
-void calculate_average_times(Process processes[], int num_processes, float* avg_waiting_time, float* avg_turnaround_time) {
-    int total_waiting_time = 0;
-    int total_turnaround_time = 0;
+void print_processes(Process processes[], int num_processes) {
+    bool with_io = false;
+    for (int i = 0; i < num_processes; i++) {
+        with_io = with_io || processes[i].num_bursts > 1;
+    }
 
+    printf(with_io ? "PID\tArrival\tBurst\tPriority\tBursts (CPU,I/O,...)\n" : "PID\tArrival\tBurst\tPriority\n");
     for (int i = 0; i < num_processes; i++) {
-        total_waiting_time += processes[i].waiting_time;
-        total_turnaround_time += processes[i].turnaround_time;
+        printf("%d\t%d\t%d\t%d", processes[i].pid, processes[i].arrival_time, processes[i].burst_time, processes[i].priority);
+        if (with_io) {
+            printf("\t");
+            for (int k = 0; k < processes[i].num_bursts; k++) {
+                printf(k > 0 ? ",%d" : "%d", processes[i].bursts[k]);
+            }
+            if (processes[i].num_bursts == 0) {
+                printf("%d", processes[i].burst_time);
+            }
+        }
+        printf("\n");
     }
+}
 
-    *avg_waiting_time = (float)total_waiting_time / num_processes;
-    *avg_turnaround_time = (float)total_turnaround_time / num_processes;
+// Bucket of a value: exact below 2 * HISTOGRAM_SUB_BUCKETS, then HISTOGRAM_SUB_BUCKETS per power of two
+int histogram_bucket(long long value) {
+    if (value < 2 * HISTOGRAM_SUB_BUCKETS) {
+        return (int)value;
+    }
+    // the top 8 significant bits pick the bucket within the value's power of two
+    int shift = 63 - __builtin_clzll((unsigned long long)value) - 7;
+    return HISTOGRAM_SUB_BUCKETS * shift + (int)(value >> shift);
+}
 
-    printf("Average Waiting Time: %.2f\n", *avg_waiting_time);
-    printf("Average Turnaround Time: %.2f\n", *avg_turnaround_time);
+// Largest value that falls in bucket
+long long histogram_bucket_value(int bucket) {
+    if (bucket < 2 * HISTOGRAM_SUB_BUCKETS) {
+        return bucket;
+    }
+    int shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    long long sub_bucket = bucket - HISTOGRAM_SUB_BUCKETS * shift;
+    return ((sub_bucket + 1) << shift) - 1;
 }
 
-void export_averages_to_csv(const char* filename, const char* algorithm_name, float avg_waiting_time, float avg_turnaround_time) {
-    FILE* fp = fopen(filename, "a");
-    if (fp == NULL) {
-        perror("Unable to open file");
+void reserve_buckets(Histogram* histogram, int num_buckets) {
+    if (num_buckets <= histogram->num_buckets) {
         return;
     }
-
-    fprintf(fp, "%s,%.2f,%.2f\n", algorithm_name, avg_waiting_time, avg_turnaround_time);
-    fclose(fp);
+    int capacity = (histogram->num_buckets > 0) ? histogram->num_buckets * 2 : 2 * HISTOGRAM_SUB_BUCKETS;
+    if (capacity < num_buckets) {
+        capacity = num_buckets;
+    }
+    if (capacity > HISTOGRAM_SIZE) {
+        capacity = HISTOGRAM_SIZE;
+    }
+    histogram->counts = grow_array(histogram->counts, capacity, sizeof(long long));
+    memset(&histogram->counts[histogram->num_buckets], 0, sizeof(long long) * (capacity - histogram->num_buckets));
+    histogram->num_buckets = capacity;
 }
 
-void fcfs_scheduling(Process processes[], int num_processes) {
-    printf("\nFCFS Scheduling:\n");
-    int current_time = 0;
-    int timeline[100];
-    int time_stamps[100];
-    int timeline_size = 0;
-
-    qsort(processes, num_processes, sizeof(Process), compare_arrival_time);
+void record_histogram(Histogram* histogram, long long value) {
+    int bucket = histogram_bucket(value);
+    if (bucket >= histogram->num_buckets) {
+        reserve_buckets(histogram, bucket + 1);
+    }
+    histogram->counts[bucket]++;
+    histogram->count++;
+    histogram->total += value;
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+}
 
-    for (int i = 0; i < num_processes; i++) {
-        if (current_time < processes[i].arrival_time) {
-            current_time = processes[i].arrival_time;
+// Nearest-rank percentile, as the largest value of its bucket (never above the maximum)
+long long histogram_percentile(const Histogram* histogram, double percentile) {
+    if (histogram->count == 0) {
+        return 0;
+    }
+    long long rank = (long long)ceil(percentile / 100.0 * histogram->count);
+    if (rank < 1) {
+        rank = 1;
+    }
+    long long seen = 0;
+    int last = histogram_bucket(histogram->max);
+    for (int bucket = 0; bucket < last; bucket++) {
+        seen += histogram->counts[bucket];
+        if (seen >= rank) {
+            long long value = histogram_bucket_value(bucket);
+            return value < histogram->max ? value : histogram->max;
         }
+    }
+    return histogram->max;
+}
 
-        processes[i].waiting_time = current_time - processes[i].arrival_time;
-        processes[i].completion_time = current_time + processes[i].burst_time;
-        processes[i].turnaround_time = processes[i].completion_time - processes[i].arrival_time;
-        current_time = processes[i].completion_time;
-
-        for (int j = 0; j < processes[i].burst_time; j++) {
-            timeline[timeline_size] = processes[i].pid;
-            time_stamps[timeline_size++] = current_time - processes[i].burst_time + j;
-        }
+double histogram_mean(const Histogram* histogram) {
+    return histogram->count > 0 ? (double)histogram->total / histogram->count : 0.0;
+}
 
-        printf("Process %d - Waiting Time: %d, Turnaround Time: %d\n",
-            processes[i].pid, processes[i].waiting_time, processes[i].turnaround_time);
+// Makes to a copy of from, reusing to's buckets. Only the buckets up to each maximum can be
+// non-zero, so the copy costs no more than the range of values recorded.
+void copy_histogram(Histogram* to, const Histogram* from) {
+    int used = (to->count > 0) ? histogram_bucket(to->max) + 1 : 0;
+    int from_used = (from->count > 0) ? histogram_bucket(from->max) + 1 : 0;
+    reserve_buckets(to, from_used);
+    if (from_used > 0) {
+        memcpy(to->counts, from->counts, sizeof(long long) * from_used);
     }
+    if (used > from_used) {
+        memset(&to->counts[from_used], 0, sizeof(long long) * (used - from_used));
+    }
+    to->count = from->count;
+    to->total = from->total;
+    to->max = from->max;
+}
 
-    print_gantt_chart(processes, num_processes, timeline, timeline_size, time_stamps);
-
-    float avg_waiting_time, avg_turnaround_time;
-    calculate_average_times(processes, num_processes, &avg_waiting_time, &avg_turnaround_time);
-    export_averages_to_csv("scheduling_results.csv", "FCFS", avg_waiting_time, avg_turnaround_time);
+// A recorded value in the metric's reporting unit
+double latency_value(int metric, double value) {
+    return metric == METRIC_SLOWDOWN ? value / SLOWDOWN_SCALE : value;
 }
 
-void non_preemptive_sjf(Process processes[], int num_processes) {
-    printf("\nNon-Preemptive SJF Scheduling:\n");
-    int current_time = 0;
-    int completed = 0;
-    int timeline[100];
-    int time_stamps[100];
-    int timeline_size = 0;
+const char* const latency_metric_names[NUM_LATENCY_METRICS] = {
+    "Waiting Time",
+    "Turnaround Time",
+    "Response Time",
+    "Slowdown",
+    "Longest Wait"
+};
 
-    while (completed != num_processes) {
-        int idx = -1;
-        int min_burst = INT_MAX;
+const double reported_percentiles[NUM_PERCENTILES] = { 50.0, 90.0, 99.0, 99.9 };
+const char* const percentile_names[NUM_PERCENTILES] = { "P50", "P90", "P99", "P99.9" };
 
-        for (int i = 0; i < num_processes; i++) {
-            if (!processes[i].completed && processes[i].arrival_time <= current_time && processes[i].burst_time < min_burst) {
-                min_burst = processes[i].burst_time;
-                idx = i;
-            }
-        }
+// 엔진이 완료 시점마다 누적한 합계로 평균을 낸다 (트레이스 실행은 프로세스 표가 재사용되므로)
+void calculate_average_times(SimulationContext* ctx) {
+    long long count = (ctx->num_completed > 0) ? ctx->num_completed : 1;
 
-        if (idx != -1) {
-            processes[idx].waiting_time = current_time - processes[idx].arrival_time;
-            processes[idx].turnaround_time = processes[idx].waiting_time + processes[idx].burst_time;
-            processes[idx].completion_time = current_time + processes[idx].burst_time;
-            current_time += processes[idx].burst_time;
-            processes[idx].completed = true;
-            completed++;
+    ctx->avg_waiting_time = (double)ctx->total_waiting_time / count;
+    ctx->avg_turnaround_time = (double)ctx->total_turnaround_time / count;
 
-            for (int j = 0; j < processes[idx].burst_time; j++) {
-                timeline[timeline_size] = processes[idx].pid;
-                time_stamps[timeline_size++] = current_time - processes[idx].burst_time + j;
+    if (REPORTS(ctx, VERBOSITY_SUMMARY)) {
+        fprintf(ctx->out, "Number of context switches: %lld\n", ctx->context_switches);
+        fprintf(ctx->out, "Average Waiting Time: %.2f\n", ctx->avg_waiting_time);
+        fprintf(ctx->out, "Average Turnaround Time: %.2f\n", ctx->avg_turnaround_time);
+        fprintf(ctx->out, "Average Response Time: %.2f\n", histogram_mean(&ctx->latency[METRIC_RESPONSE]));
+        fprintf(ctx->out, "Average Slowdown: %.2f\n", latency_value(METRIC_SLOWDOWN, histogram_mean(&ctx->latency[METRIC_SLOWDOWN])));
+        for (int metric = 0; metric < NUM_LATENCY_METRICS; metric++) {
+            const Histogram* histogram = &ctx->latency[metric];
+            fprintf(ctx->out, "%s", latency_metric_names[metric]);
+            for (int k = 0; k < NUM_PERCENTILES; k++) {
+                fprintf(ctx->out, "%s %s: %.2f", k > 0 ? "," : "", percentile_names[k],
+                    latency_value(metric, histogram_percentile(histogram, reported_percentiles[k])));
             }
-
-            printf("Process %d - Waiting Time: %d, Turnaround Time: %d\n", processes[idx].pid, processes[idx].waiting_time, processes[idx].turnaround_time);
+            fprintf(ctx->out, ", Max: %.2f\n", latency_value(metric, histogram->max));
         }
-        else {
-            current_time++;
+        fprintf(ctx->out, "Context Switch Overhead: %lld\n", ctx->switch_overhead);
+        fprintf(ctx->out, "Effective CPU Utilization: %.2f%%\n", total_cpu_utilization(ctx));
+        if (ctx->io_requests > 0) {
+            fprintf(ctx->out, "I/O Device Utilization: %.2f%%\n", device_utilization(ctx));
         }
     }
+}
 
-    print_gantt_chart(processes, num_processes, timeline, timeline_size, time_stamps);
+// Buffers the results of a process that just completed
+void record_result(SimulationContext* ctx, int idx) {
+    ResultBuffer* results = &ctx->results;
+    if (results->count == results->capacity) {
+        int capacity = (results->capacity > 0) ? results->capacity * 2 : 64;
+        for (int k = 0; k < RESULT_COLUMNS; k++) {
+            results->columns[k] = grow_array(results->columns[k], capacity, sizeof(int32_t));
+        }
+        results->capacity = capacity;
+    }
 
-    float avg_waiting_time, avg_turnaround_time;
-    calculate_average_times(processes, num_processes, &avg_waiting_time, &avg_turnaround_time);
-    export_averages_to_csv("scheduling_results.csv", "Non-Preemptive SJF", avg_waiting_time, avg_turnaround_time);
+    const ProcessTable* table = &ctx->processes;
+    int row = results->count++;
+    results->columns[0][row] = table->pid[idx];
+    results->columns[1][row] = table->arrival_time[idx];
+    results->columns[2][row] = table->burst_time[idx];
+    results->columns[3][row] = table->completion_time[idx];
+    results->columns[4][row] = table->waiting_time[idx];
+    results->columns[5][row] = table->turnaround_time[idx];
+    results->num_rows++;
+    if (results->count == RESULT_BATCH_ROWS) {
+        spill_results(ctx);
+    }
 }
 
-void preemptive_sjf(Process processes[], int num_processes) {
-    printf("\nPreemptive SJF Scheduling:\n");
-    int current_time = 0;
-    int completed = 0;
-    int timeline[100];
-    int time_stamps[100];
-    int timeline_size = 0;
-
-    while (completed != num_processes) {
-        int idx = -1;
-        int min_remaining = INT_MAX;
+// Encodes the buffered rows as CSV lines or as one columnar batch
+void write_result_batch(FILE* fp, const SimulationContext* ctx) {
+    const ResultBuffer* results = &ctx->results;
+    if (ctx->result_format == RESULTS_CSV) {
+        for (int row = 0; row < results->count; row++) {
+            fprintf(fp, "%s,%d,%d,%d,%d,%d,%d\n", ctx->algorithm_name,
+                results->columns[0][row], results->columns[1][row], results->columns[2][row],
+                results->columns[3][row], results->columns[4][row], results->columns[5][row]);
+        }
+        return;
+    }
+    uint32_t num_rows = (uint32_t)results->count;
+    fwrite(&num_rows, sizeof(num_rows), 1, fp);
+    for (int k = 0; k < RESULT_COLUMNS; k++) {
+        fwrite(results->columns[k], sizeof(int32_t), results->count, fp);
+    }
+}
 
-        for (int i = 0; i < num_processes; i++) {
-            if (!processes[i].completed && processes[i].arrival_time <= current_time && processes[i].remaining_time < min_remaining) {
-                min_remaining = processes[i].remaining_time;
-                idx = i;
-            }
+// Moves a full batch to the run's spill file, opening it on the first batch
+void spill_results(SimulationContext* ctx) {
+    ResultBuffer* results = &ctx->results;
+    if (results->spill == NULL) {
+        results->spill = tmpfile();
+        if (results->spill == NULL) {
+            perror("Unable to open result spill file");
+            exit(1);
         }
+        setvbuf(results->spill, NULL, _IOFBF, 1 << 20);
+    }
+    write_result_batch(results->spill, ctx);
+    results->num_batches++;
+    results->count = 0;
+}
 
-        if (idx != -1) {
-            processes[idx].remaining_time--;
-            timeline[timeline_size] = processes[idx].pid;
-            time_stamps[timeline_size++] = current_time;
-            current_time++;
+void reset_results(ResultBuffer* results) {
+    results->count = 0;
+    results->num_rows = 0;
+    results->num_batches = 0;
+    if (results->spill != NULL) {
+        fclose(results->spill);
+        results->spill = NULL;
+    }
+}
 
-            if (processes[idx].remaining_time == 0) {
-                processes[idx].completed = true;
-                completed++;
-                processes[idx].waiting_time = current_time - processes[idx].arrival_time - processes[idx].burst_time;
-                processes[idx].turnaround_time = current_time - processes[idx].arrival_time;
-                processes[idx].completion_time = current_time;
+bool copy_file(FILE* from, FILE* to) {
+    char buffer[1 << 16];
+    size_t size;
+    rewind(from);
+    while ((size = fread(buffer, 1, sizeof(buffer), from)) > 0) {
+        if (fwrite(buffer, 1, size, to) != size) {
+            return false;
+        }
+    }
+    return !ferror(from);
+}
 
-                printf("Process %d - Waiting Time: %d, Turnaround Time: %d\n", processes[idx].pid, processes[idx].waiting_time, processes[idx].turnaround_time);
-            }
+// Column names of scheduling_results.csv
+void write_summary_header(FILE* fp) {
+    fprintf(fp, "Algorithm,Average Waiting Time,Average Turnaround Time,Average Response Time,Average Slowdown,"
+        "Context Switches,Switch Overhead,Effective CPU Utilization");
+    for (int metric = 0; metric < NUM_LATENCY_METRICS; metric++) {
+        for (int k = 0; k < NUM_PERCENTILES; k++) {
+            fprintf(fp, ",%s %s", latency_metric_names[metric], percentile_names[k]);
         }
-        else {
-            current_time++;
+        fprintf(fp, ",%s Max", latency_metric_names[metric]);
+    }
+    fprintf(fp, "\n");
+}
+
+// One run's row of scheduling_results.csv
+void write_summary_row(FILE* fp, const SimulationContext* ctx) {
+    const Histogram* latency = ctx->latency;
+    fprintf(fp, "%s,%.2f,%.2f,%.2f,%.2f,%lld,%lld,%.2f", ctx->algorithm_name, ctx->avg_waiting_time, ctx->avg_turnaround_time,
+        histogram_mean(&latency[METRIC_RESPONSE]), latency_value(METRIC_SLOWDOWN, histogram_mean(&latency[METRIC_SLOWDOWN])),
+        ctx->context_switches, ctx->switch_overhead, total_cpu_utilization(ctx));
+    for (int metric = 0; metric < NUM_LATENCY_METRICS; metric++) {
+        for (int k = 0; k < NUM_PERCENTILES; k++) {
+            fprintf(fp, ",%.2f", latency_value(metric, histogram_percentile(&latency[metric], reported_percentiles[k])));
         }
+        fprintf(fp, ",%.2f", latency_value(metric, latency[metric].max));
     }
+    fprintf(fp, "\n");
+}
 
-    print_gantt_chart(processes, num_processes, timeline, timeline_size, time_stamps);
+// Writes scheduling_results.csv (the averages of every algorithm) and, unless format is
+// RESULTS_NONE, every run's per-process rows in algorithm order. Each file is opened once and
+// written through a large buffer.
+int write_results(SimulationContext contexts[], int num_contexts, ResultFormat format) {
+    FILE* fp = fopen("scheduling_results.csv", "w");
+    if (fp == NULL) {
+        perror("scheduling_results.csv");
+        return 1;
+    }
+    write_summary_header(fp);
+    for (int i = 0; i < num_contexts; i++) {
+        write_summary_row(fp, &contexts[i]);
+    }
+    int status = 0;
+    if (fclose(fp) != 0) {
+        perror("scheduling_results.csv");
+        status = 1;
+    }
 
-    float avg_waiting_time, avg_turnaround_time;
-    calculate_average_times(processes, num_processes, &avg_waiting_time, &avg_turnaround_time);
-    export_averages_to_csv("scheduling_results.csv", "Preemptive SJF", avg_waiting_time, avg_turnaround_time);
+#if INSTRUMENTATION
+    uint64_t export_start = read_cycles();
+#endif
+    if (format != RESULTS_NONE && write_process_results(contexts, num_contexts, format) != 0) {
+        status = 1;
+    }
+#if INSTRUMENTATION
+    if (write_instrumentation(contexts, num_contexts, read_cycles() - export_start) != 0) {
+        status = 1;
+    }
+#endif
+    return status;
 }
 
-void non_preemptive_priority(Process processes[], int num_processes) {
-    printf("\nNon-Preemptive Priority Scheduling:\n");
-    int current_time = 0;
-    int completed = 0;
-    int timeline[100];
-    int time_stamps[100];
-    int timeline_size = 0;
-
-    while (completed != num_processes) {
-        int idx = -1;
-        int max_priority = INT_MIN;
+// Copies every run's buffered per-process results into process_results.csv or .bin
+int write_process_results(SimulationContext contexts[], int num_contexts, ResultFormat format) {
+    int status = 0;
+    const char* filename = (format == RESULTS_CSV) ? "process_results.csv" : "process_results.bin";
+    FILE* fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        perror(filename);
+        return 1;
+    }
+    setvbuf(fp, NULL, _IOFBF, 1 << 20);
+    if (format == RESULTS_CSV) {
+        fprintf(fp, "Algorithm,PID,Arrival Time,Burst Time,Completion Time,Waiting Time,Turnaround Time\n");
+    }
+    else {
+        ResultFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, RESULT_MAGIC, sizeof(header.magic));
+        header.version = RESULT_VERSION;
+        header.num_sections = (uint32_t)num_contexts;
+        fwrite(&header, sizeof(header), 1, fp);
+    }
 
-        for (int i = 0; i < num_processes; i++) {
-            if (!processes[i].completed && processes[i].arrival_time <= current_time && processes[i].priority > max_priority) {
-                max_priority = processes[i].priority;
-                idx = i;
-            }
+    for (int i = 0; i < num_contexts; i++) {
+        const ResultBuffer* results = &contexts[i].results;
+        if (format == RESULTS_BINARY) {
+            ResultSectionHeader section;
+            memset(&section, 0, sizeof(section));
+            strncpy(section.algorithm, contexts[i].algorithm_name, sizeof(section.algorithm) - 1);
+            section.num_rows = (uint64_t)results->num_rows;
+            section.num_batches = (uint64_t)(results->num_batches + (results->count > 0));
+            fwrite(&section, sizeof(section), 1, fp);
         }
-
-        if (idx != -1) {
-            processes[idx].waiting_time = current_time - processes[idx].arrival_time;
-            processes[idx].turnaround_time = processes[idx].waiting_time + processes[idx].burst_time;
-            processes[idx].completion_time = current_time + processes[idx].burst_time;
-            current_time += processes[idx].burst_time;
-            processes[idx].completed = true;
-            completed++;
-
-            for (int j = 0; j < processes[idx].burst_time; j++) {
-                timeline[timeline_size] = processes[idx].pid;
-                time_stamps[timeline_size++] = current_time - processes[idx].burst_time + j;
-            }
-
-            printf("Process %d - Waiting Time: %d, Turnaround Time: %d\n", processes[idx].pid, processes[idx].waiting_time, processes[idx].turnaround_time);
+        if (results->spill != NULL && !copy_file(results->spill, fp)) {
+            perror(filename);
+            status = 1;
         }
-        else {
-            current_time++;
+        if (results->count > 0) {
+            write_result_batch(fp, &contexts[i]);
         }
     }
 
-    print_gantt_chart(processes, num_processes, timeline, timeline_size, time_stamps);
+    if (fclose(fp) != 0) {
+        perror(filename);
+        status = 1;
+    }
+    return status;
+}
+
+// Runs one scheduling policy on the shared engine and reports it under ctx->algorithm_name
+void run_policy(SimulationContext* ctx, const SchedulerConfig* config) {
+    // with aging, preemptive priority and SRTF select by their aged keys
+    SchedulerConfig aged;
+    if (ctx->aging_interval > 0 && config->preemptive && (config->key == SELECT_PRIORITY || config->key == SELECT_REMAINING)) {
+        aged = *config;
+        aged.key = (config->key == SELECT_PRIORITY) ? SELECT_AGED_PRIORITY : SELECT_AGED_REMAINING;
+        config = &aged;
+    }
+    if (REPORTS(ctx, VERBOSITY_SUMMARY)) {
+        fprintf(ctx->out, "\n%s Scheduling:\n", ctx->algorithm_name);
+    }
+    TIMED(&ctx->stats, PHASE_ENGINE, run_simulation(ctx, config));
+
+    TIMED(&ctx->stats, PHASE_REPORT, print_schedule(ctx));
 
-    float avg_waiting_time, avg_turnaround_time;
-    calculate_average_times(processes, num_processes, &avg_waiting_time, &avg_turnaround_time);
-    export_averages_to_csv("scheduling_results.csv", "Non-Preemptive Priority", avg_waiting_time, avg_turnaround_time);
+    TIMED(&ctx->stats, PHASE_REPORT, calculate_average_times(ctx));
 }
 
-void preemptive_priority(Process processes[], int num_processes) {
-    printf("\nPreemptive Priority Scheduling:\n");
-    int current_time = 0;
-    int completed = 0;
-    int timeline[100];
-    int time_stamps[100];
-    int timeline_size = 0;
+// Defines scheduler function as a fixed policy: the ready-queue key it selects by, whether an
+// arrival preempts the running process, and its quantum (0 for none). The policy is a constant,
+// so a new one is a single line here plus its entry, with its name, in algorithms.
+#define DEFINE_POLICY(function, key, preemptive, time_quantum) \
+void function(SimulationContext* ctx) { \
+    static const SchedulerConfig config = { key, preemptive, time_quantum, NULL }; \
+    run_policy(ctx, &config); \
+}
 
-    while (completed != num_processes) {
-        int idx = -1;
-        int max_priority = INT_MIN;
+DEFINE_POLICY(fcfs_scheduling, SELECT_ARRIVAL, false, 0)
+DEFINE_POLICY(non_preemptive_sjf, SELECT_BURST, false, 0)
+DEFINE_POLICY(preemptive_sjf, SELECT_REMAINING, true, 0)
+DEFINE_POLICY(non_preemptive_priority, SELECT_PRIORITY, false, 0)
+DEFINE_POLICY(preemptive_priority, SELECT_PRIORITY, true, 0)
+DEFINE_POLICY(hrrn_scheduling, SELECT_RESPONSE_RATIO, false, 0)
+DEFINE_POLICY(stride_scheduling, SELECT_PASS, false, TIME_QUANTUM)
 
-        for (int i = 0; i < num_processes; i++) {
-            if (!processes[i].completed && processes[i].arrival_time <= current_time && processes[i].priority > max_priority) {
-                max_priority = processes[i].priority;
-                idx = i;
-            }
-        }
+void round_robin(SimulationContext* ctx, int time_quantum) {
+    SchedulerConfig config = { SELECT_ARRIVAL, false, time_quantum, NULL };
+    run_policy(ctx, &config);
+}
+
+void round_robin_default(SimulationContext* ctx) {
+    round_robin(ctx, TIME_QUANTUM);
+}
 
-        if (idx != -1) {
-            processes[idx].remaining_time--;
-            timeline[timeline_size] = processes[idx].pid;
-            time_stamps[timeline_size++] = current_time;
-            current_time++;
+void mlfq_scheduling(SimulationContext* ctx, const MlfqConfig* mlfq) {
+    SchedulerConfig config = { SELECT_LEVEL, true, 0, mlfq };
+    run_policy(ctx, &config);
+}
 
-            if (processes[idx].remaining_time == 0) {
-                processes[idx].completed = true;
-                completed++;
-                processes[idx].waiting_time = current_time - processes[idx].arrival_time - processes[idx].burst_time;
-                processes[idx].turnaround_time = current_time - processes[idx].arrival_time;
-                processes[idx].completion_time = current_time;
+void mlfq_default(SimulationContext* ctx) {
+    MlfqConfig mlfq = { MLFQ_LEVELS, { 0 }, MLFQ_BOOST_INTERVAL };
+    for (int level = 0; level < MLFQ_LEVELS; level++) {
+        mlfq.quanta[level] = TIME_QUANTUM << level;
+    }
+    mlfq_scheduling(ctx, &mlfq);
+}
 
-                printf("Process %d - Waiting Time: %d, Turnaround Time: %d\n", processes[idx].pid, processes[idx].waiting_time, processes[idx].turnaround_time);
-            }
-        }
-        else {
-            current_time++;
+bool open_trace(TraceReader* reader, const char* filename, bool quiet) {
+    memset(reader, 0, sizeof(TraceReader));
+    reader->filename = filename;
+    reader->next_pid = 1;
+    reader->quiet = quiet;
+    reader->fp = fopen(filename, "r");
+    if (reader->fp == NULL) {
+        if (!quiet) {
+            perror(filename);
         }
+        return false;
     }
-
-    print_gantt_chart(processes, num_processes, timeline, timeline_size, time_stamps);
-
-    float avg_waiting_time, avg_turnaround_time;
-    calculate_average_times(processes, num_processes, &avg_waiting_time, &avg_turnaround_time);
-    export_averages_to_csv("scheduling_results.csv", "Preemptive Priority", avg_waiting_time, avg_turnaround_time);
+    return true;
 }
 
-void round_robin(Process processes[], int num_processes, int time_quantum) {
-    printf("\nRound Robin Scheduling:\n");
-    int current_time = 0;
-    int completed = 0;
-    int queue[100];
-    int front = 0;
-    int rear = -1;
-    int timeline[100];
-    int time_stamps[100];
-    int timeline_size = 0;
-    int context_switches = 0;
+void close_trace(TraceReader* reader) {
+    if (reader->fp != NULL) {
+        fclose(reader->fp);
+    }
+    free(reader->line);
+}
 
-    bool in_queue[MAX_PROCESSES] = { false };
+// Reads ahead to the next job. Blank lines, '#' comments and a non-numeric first line (a header)
+// are skipped. After priority comes either one io_burst (0 for none) or io,burst pairs, at most
+// MAX_BURSTS bursts in all. Returns false at end of trace or after a malformed or out-of-order line.
+bool trace_peek(TraceReader* reader) {
+    while (!reader->has_pending && !reader->failed) {
+        if (getline(&reader->line, &reader->line_capacity, reader->fp) < 0) {
+            return false;
+        }
+        reader->line_number++;
 
-    while (completed != num_processes) {
-        for (int i = 0; i < num_processes; i++) {
-            if (processes[i].arrival_time == current_time && !in_queue[i]) {
-                enqueue(queue, &rear, i);
-                in_queue[i] = true;
+        char* p = reader->line;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p == '\0' || *p == '#') {
+            continue;
+        }
+        if (!reader->past_header) {
+            reader->past_header = true;
+            if (!isdigit((unsigned char)*p) && *p != '-' && *p != '+') {
+                continue;
             }
         }
 
-        if (front <= rear) {
-            int idx = dequeue(queue, &front);
-            int exec_time = (processes[idx].remaining_time < time_quantum) ? processes[idx].remaining_time : time_quantum;
-            context_switches++;
-
-            for (int j = 0; j < exec_time; j++) {
-                timeline[timeline_size] = processes[idx].pid;
-                time_stamps[timeline_size++] = current_time + j;
+        // One field more than a job can have, to tell a row with too many bursts
+        long fields[3 + MAX_BURSTS];
+        int num_fields = 0;
+        while (num_fields < 3 + MAX_BURSTS) {
+            char* end;
+            fields[num_fields] = strtol(p, &end, 10);
+            if (end == p) {
+                break;
             }
+            num_fields++;
+            p = end;
+            while (isspace((unsigned char)*p) && *p != '\n') {
+                p++;
+            }
+            if (*p != ',') {
+                break;
+            }
+            p++;
+        }
 
-            processes[idx].remaining_time -= exec_time;
-            current_time += exec_time;
-
-            if (processes[idx].remaining_time == 0) {
-                processes[idx].completed = true;
-                completed++;
-                processes[idx].waiting_time = current_time - processes[idx].arrival_time - processes[idx].burst_time;
-                processes[idx].turnaround_time = current_time - processes[idx].arrival_time;
-                processes[idx].completion_time = current_time;
-
-                printf("Process %d - Waiting Time: %d, Turnaround Time: %d\n", processes[idx].pid, processes[idx].waiting_time, processes[idx].turnaround_time);
+        if (num_fields > 2 + MAX_BURSTS) {
+            if (!reader->quiet) {
+                fprintf(stderr, "%s:%ld: more than %d CPU and I/O bursts\n", reader->filename, reader->line_number, MAX_BURSTS);
             }
-            else {
-                for (int i = 0; i < num_processes; i++) {
-                    if (processes[i].arrival_time <= current_time && !in_queue[i] && !processes[i].completed) {
-                        enqueue(queue, &rear, i);
-                        in_queue[i] = true;
-                    }
-                }
-                enqueue(queue, &rear, idx);
+            reader->failed = true;
+            return false;
+        }
+        bool line_ended = (*p == '\0' || *p == '\n');
+        bool bursts_valid = true;
+        long total_burst = fields[1];
+        // A single io_burst may be 0, no I/O; every burst of a burst list takes time
+        long min_burst = (num_fields == 4) ? 0 : 1;
+        for (int k = 3; k < num_fields; k++) {
+            bursts_valid = bursts_valid && fields[k] >= min_burst && fields[k] <= INT_MAX;
+            if (k % 2 == 0) {
+                total_burst += fields[k];
             }
         }
-        else {
-            current_time++;
+        if (!line_ended || num_fields < 3 || (num_fields > 4 && num_fields % 2 == 0) || !bursts_valid || total_burst > INT_MAX
+            || fields[0] < 0 || fields[0] >= INT_MAX || fields[1] <= 0 || fields[1] > INT_MAX || fields[2] < INT_MIN || fields[2] > INT_MAX) {
+            if (!reader->quiet) {
+                fprintf(stderr, "%s:%ld: expected arrival,burst,priority[,io_burst] or arrival,burst,priority[,io,burst]...\n", reader->filename, reader->line_number);
+            }
+            reader->failed = true;
+            return false;
+        }
+        if (fields[0] < reader->last_arrival) {
+            if (!reader->quiet) {
+                fprintf(stderr, "%s:%ld: trace is not sorted by arrival time\n", reader->filename, reader->line_number);
+            }
+            reader->failed = true;
+            return false;
         }
-    }
-
-    print_gantt_chart(processes, num_processes, timeline, timeline_size, time_stamps);
-    printf("Number of context switches: %d\n", context_switches);
 
-    float avg_waiting_time, avg_turnaround_time;
-    calculate_average_times(processes, num_processes, &avg_waiting_time, &avg_turnaround_time);
-    export_averages_to_csv("scheduling_results.csv", "Round Robin", avg_waiting_time, avg_turnaround_time);
+        Process* job = &reader->pending;
+        memset(job, 0, sizeof(Process));
+        job->pid = reader->next_pid++;
+        job->arrival_time = (int)fields[0];
+        job->burst_time = (int)total_burst;
+        job->priority = (int)fields[2];
+        if (num_fields == 4) {
+            split_io_burst(job, (int)fields[3]);
+        }
+        else if (num_fields > 4) {
+            job->bursts[0] = (int)fields[1];
+            for (int k = 3; k < num_fields; k++) {
+                job->bursts[k - 2] = (int)fields[k];
+            }
+            job->num_bursts = num_fields - 2;
+        }
+        reader->last_arrival = job->arrival_time;
+        reader->has_pending = true;
+    }
+    return reader->has_pending;
 }
 
-void reset_processes(Process processes[], int num_processes) {
-    for (int i = 0; i < num_processes; i++) {
-        processes[i].remaining_time = processes[i].burst_time;
-        processes[i].waiting_time = 0;
-        processes[i].turnaround_time = 0;
-        processes[i].completion_time = 0;
-        processes[i].completed = false;
+bool is_workload_file(const char* filename) {
+    char magic[sizeof(((WorkloadHeader*)0)->magic)];
+    FILE* fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        return false;
     }
+    bool matches = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) && memcmp(magic, WORKLOAD_MAGIC, sizeof(magic)) == 0;
+    fclose(fp);
+    return matches;
 }
 
-void enqueue(int queue[], int* rear, int value) {
-    queue[++(*rear)] = value;
-}
+// Maps a binary workload read-only. Nothing is parsed or copied; the engine reads the records
+// in place and the kernel pages them in on demand.
+bool map_workload(MappedWorkload* workload, const char* filename) {
+    memset(workload, 0, sizeof(MappedWorkload));
 
-int dequeue(int queue[], int* front) {
-    return queue[(*front)++];
-}
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror(filename);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(WorkloadHeader)) {
+        fprintf(stderr, "%s: not a workload file\n", filename);
+        close(fd);
+        return false;
+    }
 
-void print_gantt_chart(Process processes[], int num_processes, int timeline[], int timeline_size, int time_stamps[]) {
-    printf("\nGantt Chart:\n");
-    for (int i = 0; i < timeline_size; i++) {
-        printf("P%d ", timeline[i]);
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror(filename);
+        return false;
     }
-    printf("\n");
-    for (int i = 0; i < timeline_size; i++) {
-        printf("%d ", time_stamps[i]);
+
+    const WorkloadHeader* header = (const WorkloadHeader*)base;
+    if (memcmp(header->magic, WORKLOAD_MAGIC, sizeof(header->magic)) != 0 || header->version != WORKLOAD_VERSION
+        || header->record_size != sizeof(WorkloadRecord)
+        || header->num_records > ((size_t)st.st_size - sizeof(WorkloadHeader)) / sizeof(WorkloadRecord)) {
+        fprintf(stderr, "%s: unsupported or truncated workload file\n", filename);
+        munmap(base, (size_t)st.st_size);
+        return false;
     }
-    printf("%d\n", time_stamps[timeline_size - 1] + 1);
+    posix_madvise(base, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+    workload->base = base;
+    workload->length = (size_t)st.st_size;
+    workload->records = (const WorkloadRecord*)((const char*)base + sizeof(WorkloadHeader));
+    workload->num_records = (long long)header->num_records;
+    return true;
 }
 
-int main() {
-    Process processes[MAX_PROCESSES];
-    int num_processes;
+void unmap_workload(MappedWorkload* workload) {
+    if (workload->base != NULL) {
+        munmap(workload->base, workload->length);
+    }
+}
 
-    // CSV file header
-    FILE* fp = fopen("scheduling_results.csv", "w");
-    if (fp != NULL) {
-        fprintf(fp, "Algorithm,Average Waiting Time,Average Turnaround Time\n");
-        fclose(fp);
+// Writes a synthetic workload already sorted by arrival: inter-arrival gaps of 0..12, bursts of
+// 1..10 (about 92% CPU load), priorities 1..10 and I/O bursts 1..5.
+int write_workload(const char* filename, long long num_records, uint64_t seed) {
+    FILE* fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        perror(filename);
+        return 1;
     }
+    setvbuf(fp, NULL, _IOFBF, 1 << 20);
 
-    scanf("%d", &num_processes);
+    WorkloadHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WORKLOAD_MAGIC, sizeof(header.magic));
+    header.version = WORKLOAD_VERSION;
+    header.record_size = sizeof(WorkloadRecord);
+    header.num_records = (uint64_t)num_records;
+    fwrite(&header, sizeof(header), 1, fp);
 
-    generate_processes(processes, num_processes);
-    print_processes(processes, num_processes);
+    uint64_t state = seed;
+    long long arrival_time = 0;
+    for (long long i = 0; i < num_records; i++) {
+        arrival_time += (long long)(next_random(&state) % 13);
+        if (arrival_time >= INT_MAX) {
+            fprintf(stderr, "%s: arrival times exceed the int range after %lld records\n", filename, i);
+            fclose(fp);
+            return 1;
+        }
 
-    // FCFS Scheduling
-    fcfs_scheduling(processes, num_processes);
-    reset_processes(processes, num_processes);
+        WorkloadRecord record;
+        record.pid = (int32_t)(i + 1);
+        record.arrival_time = (int32_t)arrival_time;
+        record.burst_time = (int32_t)(next_random(&state) % 10) + 1;
+        record.priority = (int32_t)(next_random(&state) % 10) + 1;
+        record.io_burst_time = (int32_t)(next_random(&state) % 5) + 1;
+        fwrite(&record, sizeof(record), 1, fp);
+    }
 
-    // Non-Preemptive SJF Scheduling
-    non_preemptive_sjf(processes, num_processes);
-    reset_processes(processes, num_processes);
+    if (fclose(fp) != 0) {
+        perror(filename);
+        return 1;
+    }
+    return 0;
+}
 
-    // Preemptive SJF Scheduling
-    preemptive_sjf(processes, num_processes);
-    reset_processes(processes, num_processes);
+void unpack_record(const WorkloadRecord* record, Process* process) {
+    memset(process, 0, sizeof(Process));
+    process->pid = record->pid;
+    process->arrival_time = record->arrival_time;
+    process->burst_time = record->burst_time;
+    process->priority = record->priority;
+    split_io_burst(process, record->io_burst_time);
+}
 
-    // Non-Preemptive Priority Scheduling
-    non_preemptive_priority(processes, num_processes);
-    reset_processes(processes, num_processes);
+// Reads a whole CSV trace or binary workload into memory, in file (arrival) order. NULL on error.
+Process* read_workload(const char* filename, int* num_processes) {
+    Process* workload = NULL;
+    int count = 0;
+    int capacity = 0;
 
-    // Preemptive Priority Scheduling
-    preemptive_priority(processes, num_processes);
-    reset_processes(processes, num_processes);
+    if (is_workload_file(filename)) {
+        MappedWorkload map;
+        if (!map_workload(&map, filename)) {
+            return NULL;
+        }
+        if (map.num_records >= INT_MAX) {
+            fprintf(stderr, "%s: too many records to load\n", filename);
+            unmap_workload(&map);
+            return NULL;
+        }
+        workload = grow_array(NULL, map.num_records > 0 ? (int)map.num_records : 1, sizeof(Process));
+        for (; count < map.num_records; count++) {
+            const WorkloadRecord* record = &map.records[count];
+            if ((count > 0 && record->arrival_time < map.records[count - 1].arrival_time) || record->arrival_time == INT_MAX || record->burst_time <= 0) {
+                fprintf(stderr, "workload record %d: bad burst or not sorted by arrival time\n", count);
+                unmap_workload(&map);
+                free(workload);
+                return NULL;
+            }
+            unpack_record(record, &workload[count]);
+        }
+        unmap_workload(&map);
+        *num_processes = count;
+        return workload;
+    }
 
-    // Round Robin Scheduling
-    round_robin(processes, num_processes, TIME_QUANTUM);
+    TraceReader reader;
+    if (!open_trace(&reader, filename, false)) {
+        return NULL;
+    }
+    while (trace_peek(&reader)) {
+        if (count == capacity) {
+            capacity = (capacity > 0) ? capacity * 2 : 64;
+            workload = grow_array(workload, capacity, sizeof(Process));
+        }
+        workload[count++] = reader.pending;
+        reader.has_pending = false;
+    }
+    bool failed = reader.failed;
+    close_trace(&reader);
+    if (failed) {
+        free(workload);
+        return NULL;
+    }
+    *num_processes = count;
+    return workload;
+}
 
-    return 0;
+// Time of the next arrival that has not been admitted yet, INT_MAX when there is none
+int next_arrival_time(ArrivalSource* source) {
+    if (source->reader != NULL) {
+        return trace_peek(source->reader) ? source->reader->pending.arrival_time : INT_MAX;
+    }
+    if (source->map != NULL) {
+        if (source->next_record >= source->map->num_records) {
+            return INT_MAX;
+        }
+        const WorkloadRecord* record = &source->map->records[source->next_record];
+        if (record->arrival_time < source->last_arrival || record->arrival_time == INT_MAX || record->burst_time <= 0) {
+            if (!source->quiet) {
+                fprintf(stderr, "workload record %lld: bad burst or not sorted by arrival time\n", source->next_record);
+            }
+            source->failed = true;
+            source->next_record = source->map->num_records;
+            return INT_MAX;
+        }
+        return record->arrival_time;
+    }
+    if (source->next_arrival < source->num_arrivals) {
+        return source->arrivals[source->next_arrival].arrival_time;
+    }
+    return INT_MAX;
+}
+
+// Takes a free process slot for a streamed job, growing the pool (and the ready queue that
+// indexes it) when every slot holds a live job.
+int acquire_process_slot(SimulationContext* ctx, ReadyQueue* queue) {
+    if (ctx->num_free_slots > 0) {
+        return ctx->free_slots[--ctx->num_free_slots];
+    }
+
+    int old_capacity = ctx->process_capacity;
+    reserve_processes(ctx, ctx->num_processes + 1);
+    if (ctx->process_capacity != old_capacity) {
+        ctx->free_slots = grow_array(ctx->free_slots, ctx->process_capacity, sizeof(int));
+        if (queue != NULL) {
+            resize_ready_queue(queue, ctx->ready_items, ctx->process_capacity);
+        }
+    }
+    return ctx->num_processes - 1;
+}
+
+// Takes the next arrival from the source and returns its process index. Streamed jobs are
+// stored in a free slot first; queue is the ready queue that indexes ctx->ready_items, if any.
+int take_arrival(SimulationContext* ctx, ArrivalSource* source, ReadyQueue* queue) {
+    int idx;
+    if (source->reader != NULL) {
+        idx = acquire_process_slot(ctx, queue);
+        store_process(&ctx->processes, idx, &source->reader->pending);
+        source->reader->has_pending = false;
+    }
+    else if (source->map != NULL) {
+        const WorkloadRecord* record = &source->map->records[source->next_record++];
+        Process process;
+        unpack_record(record, &process);
+        idx = acquire_process_slot(ctx, queue);
+        store_process(&ctx->processes, idx, &process);
+        source->last_arrival = record->arrival_time;
+    }
+    else {
+        idx = source->arrivals[source->next_arrival++].index;
+    }
+    if (ctx->aging_interval > 0) {
+        ctx->processes.age_origin[idx] = ctx->processes.arrival_time[idx] / ctx->aging_interval;
+    }
+    if (ctx->trace_process > 0) {
+        trace_instant(ctx, TRACE_JOBS_LANE, "Arrive", ctx->processes.pid[idx], ctx->processes.arrival_time[idx]);
+    }
+    return idx;
+}
+
+// Admits every process whose arrival time has been reached into the ready queue
+void admit_arrivals(SimulationContext* ctx, ArrivalSource* source, int current_time, ReadyQueue* queue) {
+    while (next_arrival_time(source) <= current_time) {
+        enqueue(queue, take_arrival(ctx, source, queue));
+    }
+}
+
+// Admits arrivals and processes back from I/O up to current_time, in the order they became
+// ready (arrivals first on ties)
+void admit_ready(SimulationContext* ctx, ArrivalSource* source, int current_time, ReadyQueue* queue) {
+    while (true) {
+        int io_done = ctx->device.serving >= 0 ? ctx->device.busy_until : INT_MAX;
+        if (next_arrival_time(source) <= current_time && next_arrival_time(source) <= io_done) {
+            enqueue(queue, take_arrival(ctx, source, queue));
+        }
+        else if (io_done <= current_time) {
+            enqueue(queue, next_io_return(ctx, current_time));
+        }
+        else {
+            break;
+        }
+    }
+}
+
+// Resets the run's results and points source at the workload: the arrival-sorted index of the
+// in-memory processes, or the trace / mapped workload to stream from. False if the trace
+// cannot be opened.
+bool open_arrival_source(SimulationContext* ctx, ArrivalSource* source, TraceReader* reader) {
+    ArrivalSource initial = { ctx->arrivals, 0, 0, NULL, ctx->workload_map, 0, 0, false, ctx->quiet_trace_errors };
+    *source = initial;
+    ctx->timeline.size = 0;
+    ctx->num_completed = 0;
+    ctx->total_waiting_time = 0;
+    ctx->total_turnaround_time = 0;
+    ctx->cpu_busy_time = 0;
+    ctx->io_requests = 0;
+    ctx->dispatches = 0;
+    ctx->context_switches = 0;
+    ctx->switch_overhead = 0;
+    for (int metric = 0; metric < NUM_LATENCY_METRICS; metric++) {
+        Histogram empty = { NULL, 0, 0, 0, 0 };
+        copy_histogram(&ctx->latency[metric], &empty);
+    }
+    reset_results(&ctx->results);
+    if (ctx->device.queue.table == NULL || ctx->device.queue.key != ctx->io_discipline) {
+        SchedulerConfig device_config = { ctx->io_discipline, false, 0, NULL };
+        init_ready_queue(&ctx->device.queue, ctx->device.queue.items, ctx->device.queue.capacity, &device_config, &ctx->processes);
+    }
+    ctx->device.queue.front = 0;
+    ctx->device.queue.count = 0;
+    ctx->device.serving = -1;
+    ctx->device.busy_time = 0;
+
+    if (ctx->trace_filename != NULL || ctx->workload_map != NULL) {
+        if (ctx->trace_filename != NULL) {
+            if (!open_trace(reader, ctx->trace_filename, ctx->quiet_trace_errors)) {
+                ctx->trace_failed = true;
+                return false;
+            }
+            source->reader = reader;
+        }
+        ctx->num_processes = 0;
+        ctx->num_free_slots = 0;
+        if (ctx->process_capacity > 0) {
+            ctx->free_slots = grow_array(ctx->free_slots, ctx->process_capacity, sizeof(int));
+        }
+        return true;
+    }
+
+    // A resumed run keeps the arrivals the checkpoint had admitted; the rest of the workload comes
+    // after them in index order (workloads read from traces are sorted), so only it is re-indexed
+    int first = (ctx->resume != NULL) ? ctx->resume->num_admitted : 0;
+    for (int i = first; i < ctx->num_processes; i++) {
+        ctx->arrivals[i].arrival_time = ctx->processes.arrival_time[i];
+        ctx->arrivals[i].index = i;
+    }
+    qsort(&ctx->arrivals[first], ctx->num_processes - first, sizeof(ArrivalEntry), compare_arrival_entry);
+    source->num_arrivals = ctx->num_processes;
+    return true;
+}
+
+void close_arrival_source(SimulationContext* ctx, ArrivalSource* source) {
+    if (ctx->trace_process > 0) {
+        finish_trace_export(ctx);
+    }
+    ctx->trace_failed = source->failed;
+    if (source->reader != NULL) {
+        ctx->trace_failed = source->reader->failed;
+        close_trace(source->reader);
+    }
+}
+
+// Records a finished process; a streamed job's slot goes back to the pool
+void complete_process(SimulationContext* ctx, int idx, int current_time, bool streaming) {
+    ProcessTable* table = &ctx->processes;
+    set_completed(table, idx, true);
+    table->waiting_time[idx] = current_time - table->arrival_time[idx] - table->burst_time[idx] - table->blocked_time[idx];
+    table->turnaround_time[idx] = current_time - table->arrival_time[idx];
+    table->completion_time[idx] = current_time;
+    ctx->num_completed++;
+    ctx->total_waiting_time += table->waiting_time[idx];
+    ctx->total_turnaround_time += table->turnaround_time[idx];
+    record_histogram(&ctx->latency[METRIC_WAITING], table->waiting_time[idx]);
+    record_histogram(&ctx->latency[METRIC_TURNAROUND], table->turnaround_time[idx]);
+    record_histogram(&ctx->latency[METRIC_RESPONSE], table->response_time[idx]);
+    record_histogram(&ctx->latency[METRIC_SLOWDOWN], (long long)table->turnaround_time[idx] * SLOWDOWN_SCALE / table->burst_time[idx]);
+    record_histogram(&ctx->latency[METRIC_LONGEST_WAIT], table->longest_wait[idx]);
+
+    if (ctx->trace_process > 0) {
+        trace_instant(ctx, TRACE_JOBS_LANE, "Complete", table->pid[idx], current_time);
+    }
+    if (REPORTS(ctx, VERBOSITY_PROCESS)) {
+        TIMED(&ctx->stats, PHASE_REPORT, fprintf(ctx->out, "Process %d - Waiting Time: %d, Turnaround Time: %d\n", table->pid[idx], table->waiting_time[idx], table->turnaround_time[idx]));
+    }
+    if (ctx->result_format != RESULTS_NONE) {
+        TIMED(&ctx->stats, PHASE_EXPORT, record_result(ctx, idx));
+    }
+    if (streaming) {
+        ctx->free_slots[ctx->num_free_slots++] = idx;
+    }
+}
+
+// Quantum for dispatching process idx, 0 for none
+int dispatch_quantum(const SchedulerConfig* config, const ProcessTable* table, int idx) {
+    return config->mlfq != NULL ? config->mlfq->quanta[table->level[idx]] : config->time_quantum;
+}
+
+// true if process ready becoming ready cuts the slice of process running (ready is -1 while it
+// is not known yet). MLFQ only lets in a process from a higher level than the running one.
+bool preempts_on_arrival(const SchedulerConfig* config, const ProcessTable* table, int running, int ready) {
+    if (!config->preemptive) {
+        return false;
+    }
+    if (config->mlfq == NULL) {
+        return true;
+    }
+    return ready >= 0 ? table->level[ready] < table->level[running] : table->level[running] > 0;
+}
+
+// After a slice of a process that is not finished: MLFQ moves it down a level if it used the
+// whole quantum, and stride scheduling advances its pass by the time it ran
+void end_slice(const SchedulerConfig* config, ProcessTable* table, int idx, int exec_time, int quantum) {
+    if (config->mlfq != NULL && exec_time == quantum && table->level[idx] < config->mlfq->num_levels - 1) {
+        table->level[idx]++;
+    }
+    if (config->key == SELECT_PASS) {
+        table->pass[idx] += (long long)exec_time * process_stride(table, idx);
+    }
+}
+
+// Pass a process advances per time unit it runs: inversely proportional to its tickets, its
+// priority (at least 1)
+int process_stride(const ProcessTable* table, int idx) {
+    int tickets = table->priority[idx];
+    if (tickets < 1) {
+        tickets = 1;
+    }
+    return tickets < STRIDE_ONE ? STRIDE_ONE / tickets : 1;
+}
+
+// Bookkeeping for dispatching process idx at current_time: its response time and the wait it ends
+void start_dispatch(ProcessTable* table, int idx, int current_time) {
+    if (table->response_time[idx] < 0) {
+        table->response_time[idx] = current_time - table->arrival_time[idx];
+    }
+    if (current_time - table->ready_time[idx] > table->longest_wait[idx]) {
+        table->longest_wait[idx] = current_time - table->ready_time[idx];
+    }
+}
+
+// A process whose slice was cut goes back to the ready queue at current_time. Under aging it keeps
+// the epochs it had waited when dispatched at dispatch_time: the epochs it spent running move its
+// origin on, so only time spent waiting ages it.
+void requeue_process(SimulationContext* ctx, int idx, int dispatch_time, int current_time) {
+    ProcessTable* table = &ctx->processes;
+    table->ready_time[idx] = current_time;
+    if (ctx->aging_interval > 0) {
+        table->age_origin[idx] += current_time / ctx->aging_interval - dispatch_time / ctx->aging_interval;
+    }
+}
+
+// Aged priority: when the head of the queue, still rising one level per aging epoch, overtakes
+// process idx, which runs at the level it was dispatched with at dispatch_time; INT_MAX if
+// nothing waits. The process still runs up to the first epoch boundary after run_start, so
+// switch overhead that outlasts its lead cannot leave two processes overtaking each other
+// forever. (Under aged SRTF the running process's remaining time falls at least as fast as any
+// waiting one's aged key, so nothing overtakes it between events.)
+int aging_overtake_time(const SimulationContext* ctx, const ReadyQueue* queue, int idx, int dispatch_time, int run_start) {
+    if (queue->key != SELECT_AGED_PRIORITY || queue->count == 0) {
+        return INT_MAX;
+    }
+    const ProcessTable* table = queue->table;
+    int head = queue->items[0];
+    long long epochs = AGED_PRIORITY_KEY(table, idx) - AGED_PRIORITY_KEY(table, head) + (table->pid[head] < table->pid[idx] ? 0 : 1);
+    long long overtaken = (dispatch_time / ctx->aging_interval + epochs) * ctx->aging_interval;
+    if (overtaken <= run_start) {
+        overtaken = ((long long)run_start / ctx->aging_interval + 1) * ctx->aging_interval;
+    }
+    return overtaken < INT_MAX ? (int)overtaken : INT_MAX;
+}
+
+// When the slice process idx runs on cpu from cpu->run_start ends: at the end of its CPU burst or
+// quantum, or earlier at an MLFQ boost or when the head of the CPU's queue overtakes it by aging
+int smp_slice_end(const SimulationContext* ctx, const CpuState* cpu, int idx, int next_boost) {
+    int exec_time = ctx->processes.phase_remaining[idx];
+    if (cpu->quantum > 0 && exec_time > cpu->quantum) {
+        exec_time = cpu->quantum;
+    }
+    int slice_end = cpu->run_start + exec_time;
+    if (next_boost < slice_end) {
+        slice_end = next_boost > cpu->run_start ? next_boost : cpu->run_start;
+    }
+    int overtaken = aging_overtake_time(ctx, &cpu->queue, idx, cpu->dispatch_time, cpu->run_start);
+    if (overtaken < slice_end) {
+        slice_end = overtaken > cpu->run_start ? overtaken : cpu->run_start;
+    }
+    return slice_end;
+}
+
+int first_boost_time(const SchedulerConfig* config) {
+    return config->mlfq != NULL && config->mlfq->boost_interval > 0 ? config->mlfq->boost_interval : INT_MAX;
+}
+
+// Time a CPU spends before it can run process pid at current_time. A process re-dispatched the
+// moment its own slice ended keeps the CPU for free; any other dispatch pays the dispatch
+// latency, and replacing a different process is a context switch that also pays switch_cost.
+int dispatch_overhead(SimulationContext* ctx, DispatchHistory* history, int pid, int current_time) {
+    if (history->ran && history->pid == pid && history->end == current_time) {
+        return 0;
+    }
+    int overhead = ctx->dispatch_latency;
+    if (history->ran && history->pid != pid) {
+        overhead += ctx->switch_cost;
+        ctx->context_switches++;
+    }
+    ctx->switch_overhead += overhead;
+    return overhead;
+}
+
+void save_live(Checkpoint* checkpoint, const ProcessTable* table, int idx) {
+    LiveProcess* live = &checkpoint->live[checkpoint->num_live++];
+    live->idx = idx;
+    live->remaining_time = table->remaining_time[idx];
+    live->phase = table->phase[idx];
+    live->phase_remaining = table->phase_remaining[idx];
+    live->level = table->level[idx];
+    live->next_ready = table->next_ready[idx];
+    live->blocked_time = table->blocked_time[idx];
+    live->response_time = table->response_time[idx];
+    live->ready_time = table->ready_time[idx];
+    live->pass = table->pass[idx];
+    live->age_origin = table->age_origin[idx];
+    live->longest_wait = table->longest_wait[idx];
+}
+
+// Appends a checkpoint of the single-CPU engine at the top of its loop and returns the number of
+// entries it copied: the live processes, queue contents and used histogram buckets. A run that
+// spaces checkpoints CHECKPOINT_SPACING plus that many dispatches apart spends O(1) amortized
+// time and memory per dispatch on them.
+int save_checkpoint(SimulationContext* ctx, const ReadyQueue* queue, const ArrivalSource* source, int current_time, int next_boost, const DispatchHistory* history) {
+    if (ctx->num_checkpoints == ctx->checkpoint_capacity) {
+        int capacity = (ctx->checkpoint_capacity > 0) ? ctx->checkpoint_capacity * 2 : 16;
+        ctx->checkpoints = grow_array(ctx->checkpoints, capacity, sizeof(Checkpoint));
+        memset(&ctx->checkpoints[ctx->checkpoint_capacity], 0, sizeof(Checkpoint) * (capacity - ctx->checkpoint_capacity));
+        ctx->checkpoint_capacity = capacity;
+    }
+    // entries past num_checkpoints keep their buffers for reuse
+    Checkpoint* checkpoint = &ctx->checkpoints[ctx->num_checkpoints++];
+    const ProcessTable* table = &ctx->processes;
+    const IoDevice* device = &ctx->device;
+
+    checkpoint->current_time = current_time;
+    checkpoint->next_boost = next_boost;
+    checkpoint->history = *history;
+    checkpoint->num_admitted = source->next_arrival;
+    checkpoint->queue = *queue;
+    checkpoint->device = *device;
+    checkpoint->queue_items = grow_array(checkpoint->queue_items, queue->count + 1, sizeof(int));
+    checkpoint->device_items = grow_array(checkpoint->device_items, device->queue.count + 1, sizeof(int));
+    checkpoint->live = grow_array(checkpoint->live, queue->count + device->queue.count + 1, sizeof(LiveProcess));
+    checkpoint->num_live = 0;
+
+    if (queue->key == SELECT_LEVEL) {
+        for (int level = 0; level < queue->num_levels; level++) {
+            for (int idx = queue->level_head[level]; idx >= 0; idx = table->next_ready[idx]) {
+                save_live(checkpoint, table, idx);
+            }
+        }
+    }
+    else {
+        for (int k = 0; k < queue->count; k++) {
+            checkpoint->queue_items[k] = queue->items[(queue->front + k) % queue->capacity];
+            save_live(checkpoint, table, checkpoint->queue_items[k]);
+        }
+    }
+    for (int k = 0; k < device->queue.count; k++) {
+        checkpoint->device_items[k] = device->queue.items[(device->queue.front + k) % device->queue.capacity];
+        save_live(checkpoint, table, checkpoint->device_items[k]);
+    }
+    if (device->serving >= 0) {
+        save_live(checkpoint, table, device->serving);
+    }
+
+    checkpoint->dispatches = ctx->dispatches;
+    checkpoint->num_completed = ctx->num_completed;
+    checkpoint->total_waiting_time = ctx->total_waiting_time;
+    checkpoint->total_turnaround_time = ctx->total_turnaround_time;
+    checkpoint->cpu_busy_time = ctx->cpu_busy_time;
+    checkpoint->io_requests = ctx->io_requests;
+    checkpoint->context_switches = ctx->context_switches;
+    checkpoint->switch_overhead = ctx->switch_overhead;
+    int copied = checkpoint->num_live;
+    for (int metric = 0; metric < NUM_LATENCY_METRICS; metric++) {
+        copy_histogram(&checkpoint->latency[metric], &ctx->latency[metric]);
+        copied += (ctx->latency[metric].count > 0) ? histogram_bucket(ctx->latency[metric].max) + 1 : 0;
+    }
+    checkpoint->timeline_size = ctx->timeline.size;
+    checkpoint->timeline_end = ctx->timeline.size > 0 ? ctx->timeline.segments[ctx->timeline.size - 1].end : 0;
+    return copied;
+}
+
+// Puts a freshly opened run back into the state saved in checkpoint. The table must hold the
+// run's workload, unchanged in the checkpoint's first num_admitted arrivals.
+void restore_checkpoint(SimulationContext* ctx, const Checkpoint* checkpoint, ReadyQueue* queue, ArrivalSource* source) {
+    ProcessTable* table = &ctx->processes;
+    for (int k = 0; k < checkpoint->num_live; k++) {
+        const LiveProcess* live = &checkpoint->live[k];
+        table->remaining_time[live->idx] = live->remaining_time;
+        table->phase[live->idx] = live->phase;
+        table->phase_remaining[live->idx] = live->phase_remaining;
+        table->level[live->idx] = live->level;
+        table->next_ready[live->idx] = live->next_ready;
+        table->blocked_time[live->idx] = live->blocked_time;
+        table->response_time[live->idx] = live->response_time;
+        table->ready_time[live->idx] = live->ready_time;
+        table->pass[live->idx] = live->pass;
+        table->age_origin[live->idx] = live->age_origin;
+        table->longest_wait[live->idx] = live->longest_wait;
+        set_completed(table, live->idx, false);
+    }
+
+    int* items = queue->items;
+    int capacity = queue->capacity;
+    Tournament* tournament = queue->tournament;
+    *queue = checkpoint->queue;
+    queue->items = items;
+    queue->capacity = capacity;
+    queue->table = table;
+    queue->tournament = tournament;
+    queue->front = 0;
+    if (queue->key != SELECT_LEVEL) {
+        memcpy(queue->items, checkpoint->queue_items, sizeof(int) * queue->count);
+    }
+    if (queue->key == SELECT_RESPONSE_RATIO) {
+        rebuild_tournament(queue, tournament->size);
+    }
+
+    // the device queue only grows, so its buffer still holds the checkpoint's requests
+    IoDevice* device = &ctx->device;
+    items = device->queue.items;
+    capacity = device->queue.capacity;
+    *device = checkpoint->device;
+    device->queue.items = items;
+    device->queue.capacity = capacity;
+    device->queue.table = table;
+    device->queue.front = 0;
+    memcpy(device->queue.items, checkpoint->device_items, sizeof(int) * device->queue.count);
+
+    source->next_arrival = checkpoint->num_admitted;
+    ctx->dispatches = checkpoint->dispatches;
+    ctx->num_completed = checkpoint->num_completed;
+    ctx->total_waiting_time = checkpoint->total_waiting_time;
+    ctx->total_turnaround_time = checkpoint->total_turnaround_time;
+    ctx->cpu_busy_time = checkpoint->cpu_busy_time;
+    ctx->io_requests = checkpoint->io_requests;
+    ctx->context_switches = checkpoint->context_switches;
+    ctx->switch_overhead = checkpoint->switch_overhead;
+    for (int metric = 0; metric < NUM_LATENCY_METRICS; metric++) {
+        copy_histogram(&ctx->latency[metric], &checkpoint->latency[metric]);
+    }
+    ctx->timeline.size = checkpoint->timeline_size;
+    if (ctx->timeline.size > 0) {
+        ctx->timeline.segments[ctx->timeline.size - 1].end = checkpoint->timeline_end;
+    }
+}
+
+// Blocks a process whose CPU burst just ended: it queues for the device, which starts serving
+// it at once if idle
+void start_io(SimulationContext* ctx, int idx, int current_time) {
+    ProcessTable* table = &ctx->processes;
+    IoDevice* device = &ctx->device;
+    table->phase[idx]++;
+    table->blocked_time[idx] -= current_time;
+    ctx->io_requests++;
+    if (device->serving < 0) {
+        device->serving = idx;
+        device->busy_until = current_time + table->bursts[idx * MAX_BURSTS + table->phase[idx]];
+        device->busy_time += device->busy_until - current_time;
+    }
+    else {
+        enqueue_growing(&device->queue, idx);
+    }
+}
+
+// Returns a process whose I/O has finished by current_time, moved on to its next CPU burst,
+// or -1. The device starts its next request at the moment the previous one finished.
+int next_io_return(SimulationContext* ctx, int current_time) {
+    ProcessTable* table = &ctx->processes;
+    IoDevice* device = &ctx->device;
+    if (device->serving < 0 || device->busy_until > current_time) {
+        return -1;
+    }
+
+    int idx = device->serving;
+    int finished = device->busy_until;
+    table->blocked_time[idx] += finished;
+    table->ready_time[idx] = finished;
+    if (ctx->aging_interval > 0) {
+        table->age_origin[idx] = finished / ctx->aging_interval;
+    }
+    table->phase[idx]++;
+    table->phase_remaining[idx] = table->bursts[idx * MAX_BURSTS + table->phase[idx]];
+
+    device->serving = -1;
+    if (device->queue.count > 0) {
+        device->serving = dequeue(&device->queue);
+        device->busy_until = finished + table->bursts[device->serving * MAX_BURSTS + table->phase[device->serving]];
+        device->busy_time += device->busy_until - finished;
+    }
+    return idx;
+}
+
+// Next time a process becomes ready: an arrival or the end of the device's current request
+int next_ready_time(ArrivalSource* source, const IoDevice* device) {
+    int next = next_arrival_time(source);
+    if (device->serving >= 0 && device->busy_until < next) {
+        next = device->busy_until;
+    }
+    return next;
+}
+
+// Share of the run the CPUs spent executing processes, in percent (averaged over SMP CPUs).
+// Switch overhead and migration are not counted, so this is the effective utilization.
+double total_cpu_utilization(const SimulationContext* ctx) {
+    if (ctx->makespan <= 0) {
+        return 0.0;
+    }
+    if (ctx->smp == NULL) {
+        return 100.0 * ctx->cpu_busy_time / ctx->makespan;
+    }
+    long long busy_time = 0;
+    for (int c = 0; c < ctx->smp->num_cpus; c++) {
+        busy_time += ctx->cpus[c].busy_time;
+    }
+    return 100.0 * busy_time / ((double)ctx->makespan * ctx->smp->num_cpus);
+}
+
+double device_utilization(const SimulationContext* ctx) {
+    return ctx->makespan > 0 ? 100.0 * ctx->device.busy_time / ctx->makespan : 0.0;
+}
+
+// Discrete-event engine shared by all algorithms. Instead of advancing one time unit at a
+// time, each dispatch runs until the next scheduling event (completion, quantum expiry, or an
+// arrival that may preempt), and an idle CPU jumps straight to the next arrival.
+// Switch overhead is paid before the slice and cannot be preempted; an event that falls inside
+// it ends the slice without any execution.
+// With ctx->checkpointing an in-memory run saves checkpoints as it goes, and with ctx->resume
+// set it starts from that checkpoint. A resumed run that saves checkpoints drops the ones after
+// it; one that does not leaves them all for later resumes.
+void run_simulation(SimulationContext* ctx, const SchedulerConfig* config) {
+    if (ctx->smp != NULL) {
+        run_smp_simulation(ctx, config);
+        return;
+    }
+
+    ArrivalSource source;
+    TraceReader reader;
+    if (!open_arrival_source(ctx, &source, &reader)) {
+        return;
+    }
+    bool streaming = ctx->trace_filename != NULL || ctx->workload_map != NULL;
+    // the timeline only feeds the Gantt chart
+    bool keep_timeline = !streaming && REPORTS(ctx, VERBOSITY_SCHEDULE);
+    bool record = keep_timeline || ctx->trace_process > 0;
+    if (ctx->trace_process > 0) {
+        start_trace_export(ctx, 1);
+    }
+
+    bool checkpointing = ctx->checkpointing && !streaming;
+
+    ProcessTable* table = &ctx->processes;
+    ReadyQueue queue;
+    init_ready_queue(&queue, ctx->ready_items, ctx->process_capacity, config, table);
+    queue.stats = &ctx->stats;
+    if (config->key == SELECT_RESPONSE_RATIO) {
+        queue.tournament = &ctx->tournament;
+        rebuild_tournament(&queue, ctx->tournament.size);
+    }
+    ctx->device.queue.stats = &ctx->stats;
+    if (!streaming) {
+        // The scan breaks ties by index and the heap by pid, so scanning needs pids in index order
+        // and it treats every arrived process as ready, so it cannot be used with I/O.
+        // Checkpoints save and restore the queue contents, which scan mode does not keep.
+        queue.scan = (config->key == SELECT_BURST || config->key == SELECT_REMAINING || config->key == SELECT_PRIORITY)
+            && ctx->num_processes <= SCAN_SELECT_LIMIT && !checkpointing && ctx->resume == NULL;
+        for (int i = 0; i < ctx->num_processes && queue.scan; i++) {
+            queue.scan = (i == 0 || table->pid[i] > table->pid[i - 1]) && table->num_bursts[i] == 1;
+        }
+        queue.scan_size = ctx->num_processes;
+    }
+    int next_boost = first_boost_time(config);
+    int current_time = 0;
+    DispatchHistory history = { false, 0, 0 };
+    int preempted = -1;
+    long long next_checkpoint = 0;
+    if (ctx->resume != NULL) {
+        restore_checkpoint(ctx, ctx->resume, &queue, &source);
+        current_time = ctx->resume->current_time;
+        next_boost = ctx->resume->next_boost;
+        history = ctx->resume->history;
+        if (checkpointing) {
+            ctx->num_checkpoints = (int)(ctx->resume - ctx->checkpoints) + 1;
+        }
+        ctx->resume = NULL;
+        next_checkpoint = ctx->dispatches + CHECKPOINT_SPACING;
+    }
+    else if (checkpointing) {
+        ctx->num_checkpoints = 0;
+    }
+
+    while (true) {
+        if (checkpointing && ctx->dispatches >= next_checkpoint) {
+            next_checkpoint = ctx->dispatches + CHECKPOINT_SPACING + save_checkpoint(ctx, &queue, &source, current_time, next_boost, &history);
+        }
+        TIMED(&ctx->stats, PHASE_ADMIT, admit_ready(ctx, &source, current_time, &queue));
+        if (current_time >= next_boost) {
+            boost_levels(&queue);
+            next_boost = current_time - current_time % config->mlfq->boost_interval + config->mlfq->boost_interval;
+        }
+
+        if (queue.count == 0) {
+            if (next_ready_time(&source, &ctx->device) == INT_MAX) {
+                break;
+            }
+            current_time = next_ready_time(&source, &ctx->device);
+            continue;
+        }
+        int idx;
+        queue.now = current_time;
+        TIMED(&ctx->stats, PHASE_SELECT, idx = dequeue(&queue));
+        ctx->dispatches++;
+        COUNT(&ctx->stats, decisions, 1);
+        // The slice that went back to the queue was only preempted if another process gets the CPU
+        if (preempted >= 0 && preempted != idx) {
+            COUNT(&ctx->stats, preemptions, 1);
+            if (ctx->trace_process > 0) {
+                trace_instant(ctx, 0, "Preempt", table->pid[preempted], current_time);
+            }
+        }
+        preempted = -1;
+        start_dispatch(table, idx, current_time);
+        int dispatch_time = current_time;
+        int overhead = dispatch_overhead(ctx, &history, table->pid[idx], current_time);
+        if (overhead > 0 && record) {
+            record_segment(ctx, &ctx->timeline, keep_timeline, 0, SWITCH_PID, current_time, current_time + overhead);
+        }
+        current_time += overhead;
+
+        int quantum = dispatch_quantum(config, table, idx);
+        int exec_time;
+        bool cut;
+        while (true) {
+            exec_time = table->phase_remaining[idx];
+            if (quantum > 0 && exec_time > quantum) {
+                exec_time = quantum;
+                // (not for MLFQ, where each expiry also demotes, nor for stride scheduling, where each
+                // re-dispatch moves the pass that new arrivals join at)
+                int next_ready = next_ready_time(&source, &ctx->device);
+                if (queue.count == 0 && config->mlfq == NULL && config->key != SELECT_PASS && next_ready - current_time > quantum) {
+                    // Nothing else is ready, so the process keeps the CPU at every quantum expiry
+                    // until one falls at or after the next arrival: run those quanta as one slice
+                    exec_time = table->phase_remaining[idx];
+                    if (next_ready - current_time < exec_time) {
+                        int quanta = (next_ready - current_time + quantum - 1) / quantum;
+                        if (quanta * quantum < exec_time) {
+                            exec_time = quanta * quantum;
+                        }
+                    }
+                }
+            }
+            int until_ready = next_ready_time(&source, &ctx->device) - current_time;
+            cut = preempts_on_arrival(config, table, idx, -1) && until_ready < exec_time;
+            if (cut) {
+                exec_time = until_ready > 0 ? until_ready : 0;
+            }
+            if (next_boost - current_time < exec_time) {
+                exec_time = next_boost > current_time ? next_boost - current_time : 0;
+                cut = false;
+            }
+            int overtaken = aging_overtake_time(ctx, &queue, idx, dispatch_time, current_time);
+            if (overtaken - current_time < exec_time) {
+                exec_time = overtaken > current_time ? overtaken - current_time : 0;
+                cut = false;
+            }
+
+            if (exec_time > 0 && record) {
+                record_segment(ctx, &ctx->timeline, keep_timeline, 0, table->pid[idx], current_time, current_time + exec_time);
+            }
+
+            table->remaining_time[idx] -= exec_time;
+            table->phase_remaining[idx] -= exec_time;
+            ctx->cpu_busy_time += exec_time;
+            current_time += exec_time;
+            history.ran = true;
+            history.pid = table->pid[idx];
+            history.end = current_time;
+            if (!cut || table->phase_remaining[idx] == 0) {
+                break;
+            }
+
+            // Cut off by a process becoming ready: unless the queue now holds one that goes
+            // before it, it keeps the CPU and the rest of its quantum, without a new dispatch
+            TIMED(&ctx->stats, PHASE_ADMIT, admit_ready(ctx, &source, current_time, &queue));
+            requeue_process(ctx, idx, dispatch_time, current_time);
+            dispatch_time = current_time;
+            if (ready_queue_displaces(&queue, idx)) {
+                break;
+            }
+            if (quantum > 0) {
+                quantum -= exec_time;
+            }
+        }
+
+        if (table->remaining_time[idx] == 0) {
+            complete_process(ctx, idx, current_time, streaming);
+            continue;
+        }
+        end_slice(config, table, idx, exec_time, quantum);
+        // In the FIFO, processes that became ready during the slice go ahead of the preempted
+        // one; this also brings the device up to current_time before a new request
+        TIMED(&ctx->stats, PHASE_ADMIT, admit_ready(ctx, &source, current_time, &queue));
+        if (table->phase_remaining[idx] == 0) {
+            start_io(ctx, idx, current_time);
+        }
+        else {
+            if (!cut) {
+                requeue_process(ctx, idx, dispatch_time, current_time);
+            }
+            enqueue(&queue, idx);
+            preempted = idx;
+        }
+    }
+
+    ctx->makespan = current_time;
+    close_arrival_source(ctx, &source);
+}
+
+// SMP engine: every CPU keeps its own run queue and runs its own slices. The load balancer
+// places each arrival on a CPU, and an idle CPU whose queue is empty may steal from another.
+// A process that resumes on a different CPU than it last ran on first spends migration_cost
+// there, after any switch overhead; neither can be preempted. An arrival only preempts the CPU
+// it is placed on. With one CPU this schedules exactly like run_simulation, except that an MLFQ
+// boost due during switch overhead takes effect at the next event rather than after the switch.
+void run_smp_simulation(SimulationContext* ctx, const SchedulerConfig* config) {
+    const SmpConfig* smp = ctx->smp;
+    ArrivalSource source;
+    TraceReader reader;
+    if (!open_arrival_source(ctx, &source, &reader)) {
+        return;
+    }
+    bool streaming = ctx->trace_filename != NULL || ctx->workload_map != NULL;
+    bool keep_timeline = !streaming && REPORTS(ctx, VERBOSITY_SCHEDULE);
+    bool record = keep_timeline || ctx->trace_process > 0;
+    if (ctx->trace_process > 0) {
+        start_trace_export(ctx, smp->num_cpus);
+    }
+
+    ProcessTable* table = &ctx->processes;
+    if (ctx->num_cpus < smp->num_cpus) {
+        ctx->cpus = grow_array(ctx->cpus, smp->num_cpus, sizeof(CpuState));
+        memset(&ctx->cpus[ctx->num_cpus], 0, sizeof(CpuState) * (smp->num_cpus - ctx->num_cpus));
+        ctx->num_cpus = smp->num_cpus;
+    }
+    int num_cpus = smp->num_cpus;
+    CpuState* cpus = ctx->cpus;
+    ctx->device.queue.stats = &ctx->stats;
+    for (int c = 0; c < num_cpus; c++) {
+        init_ready_queue(&cpus[c].queue, cpus[c].queue.items, cpus[c].queue.capacity, config, table);
+        cpus[c].queue.stats = &ctx->stats;
+        if (config->key == SELECT_RESPONSE_RATIO) {
+            cpus[c].queue.tournament = &cpus[c].tournament;
+            rebuild_tournament(&cpus[c].queue, cpus[c].tournament.size);
+        }
+        cpus[c].running = -1;
+        cpus[c].cut = false;
+        cpus[c].preempted = -1;
+        cpus[c].timeline.size = 0;
+        cpus[c].history.ran = false;
+        cpus[c].busy_time = 0;
+        cpus[c].migration_time = 0;
+        cpus[c].migrations = 0;
+    }
+    int next_boost = first_boost_time(config);
+    int current_time = 0;
+
+    while (true) {
+        TIMED(&ctx->stats, PHASE_ADMIT, place_ready(ctx, &source, config, current_time));
+
+        for (int c = 0; c < num_cpus; c++) {
+            CpuState* cpu = &cpus[c];
+            if (cpu->running < 0 || cpu->slice_end > current_time) {
+                continue;
+            }
+            int idx = cpu->running;
+            int exec_time = current_time - cpu->run_start;
+            cpu->running = -1;
+            cpu->migration_time += cpu->run_start - cpu->dispatch_time - cpu->overhead;
+            cpu->busy_time += exec_time;
+            cpu->history.ran = true;
+            cpu->history.pid = table->pid[idx];
+            cpu->history.end = current_time;
+            table->last_cpu[idx] = c;
+            if (exec_time > 0) {
+                table->remaining_time[idx] -= exec_time;
+                table->phase_remaining[idx] -= exec_time;
+                if (record) {
+                    record_segment(ctx, &cpu->timeline, keep_timeline, c, table->pid[idx], cpu->run_start, current_time);
+                }
+            }
+
+            if (table->remaining_time[idx] == 0) {
+                complete_process(ctx, idx, current_time, streaming);
+                continue;
+            }
+            end_slice(config, table, idx, exec_time, cpu->quantum);
+            if (table->phase_remaining[idx] == 0) {
+                start_io(ctx, idx, current_time);
+                continue;
+            }
+            requeue_process(ctx, idx, cpu->dispatch_time, current_time);
+            if (cpu->cut && current_time < next_boost && !ready_queue_displaces(&cpu->queue, idx)) {
+                // Nothing that became ready goes before it: it keeps the CPU and the rest of its
+                // quantum, without a new dispatch
+                if (cpu->quantum > 0) {
+                    cpu->quantum -= exec_time;
+                }
+                cpu->running = idx;
+                cpu->dispatch_time = current_time;
+                cpu->run_start = current_time;
+                cpu->overhead = 0;
+                cpu->cut = false;
+                cpu->slice_end = smp_slice_end(ctx, cpu, idx, next_boost);
+                continue;
+            }
+            enqueue_growing(&cpu->queue, idx);
+            cpu->preempted = idx;
+        }
+
+        if (current_time >= next_boost) {
+            for (int c = 0; c < num_cpus; c++) {
+                boost_levels(&cpus[c].queue);
+            }
+            next_boost = current_time - current_time % config->mlfq->boost_interval + config->mlfq->boost_interval;
+        }
+
+        // Idle CPUs first take from their own queue; only then do the ones still idle steal,
+        // and only while some queue still has work
+        int next_event = next_ready_time(&source, &ctx->device);
+        int queued = 0;
+        for (int c = 0; c < num_cpus; c++) {
+            queued += cpus[c].queue.count;
+        }
+        for (int pass = 0; pass < 2 && queued > 0; pass++) {
+            for (int c = 0; c < num_cpus && queued > 0; c++) {
+                CpuState* cpu = &cpus[c];
+                if (cpu->running >= 0) {
+                    continue;
+                }
+                int from = c;
+                if (cpu->queue.count == 0) {
+                    if (pass == 0 || smp->balancer->steal == NULL) {
+                        continue;
+                    }
+                    from = smp->balancer->steal(cpus, num_cpus, c);
+                    if (from < 0) {
+                        continue;
+                    }
+                }
+                else if (pass == 1) {
+                    continue;
+                }
+
+                int idx;
+                cpus[from].queue.now = current_time;
+                TIMED(&ctx->stats, PHASE_SELECT, idx = dequeue(&cpus[from].queue));
+                ctx->dispatches++;
+                COUNT(&ctx->stats, decisions, 1);
+                if (cpu->preempted >= 0 && cpu->preempted != idx) {
+                    COUNT(&ctx->stats, preemptions, 1);
+                    if (ctx->trace_process > 0) {
+                        trace_instant(ctx, c, "Preempt", table->pid[cpu->preempted], current_time);
+                    }
+                }
+                cpu->preempted = -1;
+                start_dispatch(table, idx, current_time);
+                queued--;
+                cpu->running = idx;
+                cpu->dispatch_time = current_time;
+                cpu->overhead = dispatch_overhead(ctx, &cpu->history, table->pid[idx], current_time);
+                if (cpu->overhead > 0 && record) {
+                    record_segment(ctx, &cpu->timeline, keep_timeline, c, SWITCH_PID, current_time, current_time + cpu->overhead);
+                }
+                cpu->run_start = current_time + cpu->overhead;
+                if (table->last_cpu[idx] >= 0 && table->last_cpu[idx] != c) {
+                    cpu->run_start += smp->migration_cost;
+                    cpu->migrations++;
+                }
+                cpu->quantum = dispatch_quantum(config, table, idx);
+                cpu->cut = false;
+                cpu->slice_end = smp_slice_end(ctx, cpu, idx, next_boost);
+            }
+        }
+        for (int c = 0; c < num_cpus; c++) {
+            if (cpus[c].running >= 0 && cpus[c].slice_end < next_event) {
+                next_event = cpus[c].slice_end;
+            }
+        }
+
+        if (next_event == INT_MAX) {
+            break;
+        }
+        current_time = next_event;
+    }
+
+    ctx->makespan = current_time;
+    close_arrival_source(ctx, &source);
+}
+
+// SMP admission: arrivals are placed by the balancer, and a process back from I/O returns to the
+// CPU it last ran on. Both are taken in the order they became ready, arrivals first on ties,
+// and may cut the slice of the CPU they are queued on.
+void place_ready(SimulationContext* ctx, ArrivalSource* source, const SchedulerConfig* config, int current_time) {
+    ProcessTable* table = &ctx->processes;
+    CpuState* cpus = ctx->cpus;
+    while (next_ready_time(source, &ctx->device) <= current_time) {
+        CpuState* cpu;
+        int idx;
+        if (next_arrival_time(source) == next_ready_time(source, &ctx->device)) {
+            idx = take_arrival(ctx, source, NULL);
+            cpu = &cpus[ctx->smp->balancer->place(cpus, ctx->smp->num_cpus, table, idx)];
+        }
+        else {
+            idx = next_io_return(ctx, current_time);
+            cpu = &cpus[table->last_cpu[idx]];
+        }
+        enqueue_growing(&cpu->queue, idx);
+        if (cpu->running >= 0 && preempts_on_arrival(config, table, cpu->running, idx) && cpu->slice_end > current_time) {
+            cpu->slice_end = current_time > cpu->run_start ? current_time : cpu->run_start;
+            cpu->cut = true;
+        }
+    }
+}
+
+// Enqueues on a queue that owns its item buffer (an SMP run queue or the device queue),
+// growing the buffer when full
+void enqueue_growing(ReadyQueue* queue, int idx) {
+    if (queue->count == queue->capacity) {
+        int capacity = (queue->capacity > 0) ? queue->capacity * 2 : 64;
+        resize_ready_queue(queue, grow_array(queue->items, capacity, sizeof(int)), capacity);
+    }
+    enqueue(queue, idx);
+}
+
+// Places an arrival on the CPU with the fewest queued plus running processes
+int place_least_loaded(const CpuState cpus[], int num_cpus, const ProcessTable* table, int idx) {
+    (void)table;
+    (void)idx;
+    int best = 0;
+    int best_load = INT_MAX;
+    for (int c = 0; c < num_cpus; c++) {
+        int load = cpus[c].queue.count + (cpus[c].running >= 0);
+        if (load < best_load) {
+            best = c;
+            best_load = load;
+        }
+    }
+    return best;
+}
+
+// Places an arrival on CPU pid mod num_cpus
+int place_by_pid(const CpuState cpus[], int num_cpus, const ProcessTable* table, int idx) {
+    (void)cpus;
+    return ((table->pid[idx] % num_cpus) + num_cpus) % num_cpus;
+}
+
+// Steals from the CPU with the longest run queue, -1 if every queue is empty
+int steal_busiest(const CpuState cpus[], int num_cpus, int thief) {
+    int victim = -1;
+    int most = 0;
+    for (int c = 0; c < num_cpus; c++) {
+        if (c != thief && cpus[c].queue.count > most) {
+            victim = c;
+            most = cpus[c].queue.count;
+        }
+    }
+    return victim;
+}
+
+// Share of the run a CPU spent executing processes, in percent
+double cpu_utilization(const SimulationContext* ctx, int cpu) {
+    return ctx->makespan > 0 ? 100.0 * ctx->cpus[cpu].busy_time / ctx->makespan : 0.0;
+}
+
+// Gantt chart of the run; in SMP mode one chart per CPU followed by per-core counters
+void print_schedule(SimulationContext* ctx) {
+    if (ctx->smp == NULL) {
+        if (REPORTS(ctx, VERBOSITY_SCHEDULE)) {
+            print_gantt_chart(ctx->out, "Gantt Chart", ctx->timeline.segments, ctx->timeline.size);
+        }
+        return;
+    }
+
+    char title[32];
+    for (int c = 0; c < ctx->smp->num_cpus && REPORTS(ctx, VERBOSITY_SCHEDULE); c++) {
+        snprintf(title, sizeof(title), "CPU %d Gantt Chart", c);
+        print_gantt_chart(ctx->out, title, ctx->cpus[c].timeline.segments, ctx->cpus[c].timeline.size);
+    }
+    for (int c = 0; c < ctx->smp->num_cpus && REPORTS(ctx, VERBOSITY_SUMMARY); c++) {
+        fprintf(ctx->out, "CPU %d - Busy Time: %lld, Migrations: %lld, Migration Time: %lld, Utilization: %.2f%%\n",
+            c, ctx->cpus[c].busy_time, ctx->cpus[c].migrations, ctx->cpus[c].migration_time, cpu_utilization(ctx, c));
+    }
+}
+
+// Heap key of process i: smaller values are dispatched first (the priority heap flips the
+// comparison), ties go to the lower pid
+#define BURST_KEY(table, i) ((table)->burst_time[i])
+#define REMAINING_KEY(table, i) ((table)->remaining_time[i])
+#define PRIORITY_KEY(table, i) ((table)->priority[i])
+#define IO_BURST_KEY(table, i) ((table)->bursts[(i) * MAX_BURSTS + (table)->phase[i]])
+#define PASS_KEY(table, i) ((table)->pass[i])
+
+// Defines the binary heap for one ordering key: heap_before_<name>, heap_push_<name> and
+// heap_pop_<name>. Each key gets its own copy of the sift loops with the comparison inlined, so
+// a heap operation branches on the key once instead of at every comparison.
+#define DEFINE_READY_HEAP(name, KEY, op) \
+static inline bool heap_before_##name(const ProcessTable* table, int a, int b) { \
+    return KEY(table, a) != KEY(table, b) ? KEY(table, a) op KEY(table, b) : table->pid[a] < table->pid[b]; \
+} \
+static inline void heap_push_##name(ReadyQueue* queue, int value) { \
+    int* items = queue->items; \
+    int i = queue->count++; \
+    while (i > 0) { \
+        int parent = (i - 1) / 2; \
+        if (!heap_before_##name(queue->table, value, items[parent])) { \
+            break; \
+        } \
+        items[i] = items[parent]; \
+        i = parent; \
+    } \
+    items[i] = value; \
+} \
+static inline int heap_pop_##name(ReadyQueue* queue) { \
+    int* items = queue->items; \
+    int value = items[0]; \
+    COUNT_QUEUE(queue, candidates, 1); \
+    int last = items[--queue->count]; \
+    int i = 0; \
+    while (2 * i + 1 < queue->count) { \
+        int child = 2 * i + 1; \
+        if (child + 1 < queue->count && heap_before_##name(queue->table, items[child + 1], items[child])) { \
+            child++; \
+        } \
+        COUNT_QUEUE(queue, candidates, child + 1 < queue->count ? 2 : 1); \
+        if (!heap_before_##name(queue->table, items[child], last)) { \
+            break; \
+        } \
+        items[i] = items[child]; \
+        i = child; \
+    } \
+    items[i] = last; \
+    return value; \
+}
+
+DEFINE_READY_HEAP(burst, BURST_KEY, <)
+DEFINE_READY_HEAP(remaining, REMAINING_KEY, <)
+DEFINE_READY_HEAP(priority, PRIORITY_KEY, >)
+DEFINE_READY_HEAP(io_burst, IO_BURST_KEY, <)
+DEFINE_READY_HEAP(pass, PASS_KEY, <)
+DEFINE_READY_HEAP(aged_priority, AGED_PRIORITY_KEY, >)
+DEFINE_READY_HEAP(aged_remaining, AGED_REMAINING_KEY, <)
+
+void enqueue(ReadyQueue* queue, int value) {
+    COUNT_QUEUE(queue, enqueues, 1);
+    if (queue->scan) {
+        // arrivals are admitted in order, so everything up to the latest one is ready
+        if (queue->table->arrival_time[value] > queue->scan_limit) {
+            queue->scan_limit = queue->table->arrival_time[value];
+        }
+        queue->count++;
+        return;
+    }
+    if (queue->key == SELECT_LEVEL) {
+        int level = queue->table->level[value];
+        queue->table->next_ready[value] = -1;
+        if (queue->level_head[level] < 0) {
+            queue->level_head[level] = value;
+        }
+        else {
+            queue->table->next_ready[queue->level_tail[level]] = value;
+        }
+        queue->level_tail[level] = value;
+        queue->count++;
+        return;
+    }
+    switch (queue->key) {
+    case SELECT_ARRIVAL:
+        queue->items[(queue->front + queue->count) % queue->capacity] = value;
+        queue->count++;
+        break;
+    case SELECT_BURST:
+        heap_push_burst(queue, value);
+        break;
+    case SELECT_REMAINING:
+        heap_push_remaining(queue, value);
+        break;
+    case SELECT_PRIORITY:
+        heap_push_priority(queue, value);
+        break;
+    case SELECT_IO_BURST:
+        heap_push_io_burst(queue, value);
+        break;
+    case SELECT_AGED_PRIORITY:
+        heap_push_aged_priority(queue, value);
+        break;
+    case SELECT_AGED_REMAINING:
+        heap_push_aged_remaining(queue, value);
+        break;
+    case SELECT_PASS:
+        // joining (or returning from I/O) at the queue's current pass, so time away earns no credit
+        if (queue->table->pass[value] < queue->pass) {
+            queue->table->pass[value] = queue->pass;
+        }
+        heap_push_pass(queue, value);
+        break;
+    case SELECT_RESPONSE_RATIO:
+        if (queue->count == queue->tournament->size) {
+            rebuild_tournament(queue, queue->count > 0 ? queue->count * 2 : 64);
+        }
+        queue->items[queue->count++] = value;
+        update_tournament(queue, queue->count - 1);
+        break;
+    case SELECT_LEVEL:
+        break;
+    }
+}
+
+int dequeue(ReadyQueue* queue) {
+    COUNT_QUEUE(queue, dequeues, 1);
+    if (queue->scan) {
+        COUNT_QUEUE(queue, candidates, queue->scan_size);
+        queue->count--;
+        return select_process(queue->table, queue->scan_size, queue->scan_limit, queue->key);
+    }
+    if (queue->key == SELECT_LEVEL) {
+        int level = 0;
+        while (queue->level_head[level] < 0) {
+            level++;
+        }
+        COUNT_QUEUE(queue, candidates, level + 1);
+        int value = queue->level_head[level];
+        queue->level_head[level] = queue->table->next_ready[value];
+        queue->count--;
+        return value;
+    }
+
+    switch (queue->key) {
+    case SELECT_BURST:
+        return heap_pop_burst(queue);
+    case SELECT_REMAINING:
+        return heap_pop_remaining(queue);
+    case SELECT_PRIORITY:
+        return heap_pop_priority(queue);
+    case SELECT_IO_BURST:
+        return heap_pop_io_burst(queue);
+    case SELECT_AGED_PRIORITY:
+        return heap_pop_aged_priority(queue);
+    case SELECT_AGED_REMAINING:
+        return heap_pop_aged_remaining(queue);
+    case SELECT_PASS: {
+        int value = heap_pop_pass(queue);
+        queue->pass = queue->table->pass[value];
+        return value;
+    }
+    case SELECT_RESPONSE_RATIO: {
+        refresh_tournament(queue, 1);
+        int position = queue->tournament->winner[1];
+        int value = queue->items[position];
+        int last = --queue->count;
+        queue->items[position] = queue->items[last];
+        update_tournament(queue, last);
+        if (position != last) {
+            update_tournament(queue, position);
+        }
+        return value;
+    }
+    default: {
+        COUNT_QUEUE(queue, candidates, 1);
+        int value = queue->items[queue->front];
+        queue->front = (queue->front + 1) % queue->capacity;
+        queue->count--;
+        return value;
+    }
+    }
+}
+
+// true if the queue would dispatch a process before idx, which holds the CPU and has just been
+// cut off by a process becoming ready; under MLFQ only a process from a higher level goes first
+bool ready_queue_displaces(ReadyQueue* queue, int idx) {
+    const ProcessTable* table = queue->table;
+    if (queue->count == 0) {
+        return false;
+    }
+    if (queue->scan) {
+        return select_process(table, queue->scan_size, queue->scan_limit, queue->key) != idx;
+    }
+    switch (queue->key) {
+    case SELECT_LEVEL: {
+        int level = 0;
+        while (level < table->level[idx] && queue->level_head[level] < 0) {
+            level++;
+        }
+        return level < table->level[idx];
+    }
+    case SELECT_REMAINING:
+        return heap_before_remaining(table, queue->items[0], idx);
+    case SELECT_PRIORITY:
+        return heap_before_priority(table, queue->items[0], idx);
+    case SELECT_AGED_PRIORITY:
+        return heap_before_aged_priority(table, queue->items[0], idx);
+    case SELECT_AGED_REMAINING:
+        return heap_before_aged_remaining(table, queue->items[0], idx);
+    default:
+        return true;
+    }
+}
+
+void init_ready_queue(ReadyQueue* queue, int* items, int capacity, const SchedulerConfig* config, ProcessTable* table) {
+    ReadyQueue initial = { items, capacity, 0, 0, config->key, table, 0, { 0 }, { 0 }, false, 0, INT_MIN, NULL, NULL, 0, 0 };
+    *queue = initial;
+    if (config->mlfq != NULL) {
+        queue->num_levels = config->mlfq->num_levels;
+        for (int level = 0; level < queue->num_levels; level++) {
+            queue->level_head[level] = -1;
+        }
+    }
+}
+
+// Moves the queue onto a larger buffer that already holds its items (grown with realloc)
+void resize_ready_queue(ReadyQueue* queue, int* items, int capacity) {
+    int old_capacity = queue->capacity;
+    queue->items = items;
+    // unwrap the FIFO ring into the enlarged buffer
+    if (queue->key == SELECT_ARRIVAL && queue->front + queue->count > old_capacity) {
+        memcpy(&queue->items[old_capacity], queue->items, sizeof(int) * (queue->front + queue->count - old_capacity));
+    }
+    queue->capacity = capacity;
+}
+
+// Response ratio order at time now: (now - ready) / burst of the current CPU burst, larger first,
+// ties to the lower pid. Products of two ints cannot overflow a long long.
+static inline bool ratio_before(const ProcessTable* table, int a, int b, int now) {
+    long long ratio_a = (long long)(now - table->ready_time[a]) * table->phase_remaining[b];
+    long long ratio_b = (long long)(now - table->ready_time[b]) * table->phase_remaining[a];
+    return ratio_a != ratio_b ? ratio_a > ratio_b : table->pid[a] < table->pid[b];
+}
+
+// First time at which loser comes before winner, INT_MAX if never. The difference of their
+// scaled ratios, (t - ready_l) * burst_w - (t - ready_w) * burst_l, is slope * t - crossing, so
+// only a loser with the shorter burst catches up.
+int overtake_time(const ProcessTable* table, int winner, int loser) {
+    long long slope = (long long)table->phase_remaining[winner] - table->phase_remaining[loser];
+    if (slope <= 0) {
+        return INT_MAX;
+    }
+    long long crossing = (long long)table->ready_time[loser] * table->phase_remaining[winner]
+        - (long long)table->ready_time[winner] * table->phase_remaining[loser];
+    long long t = crossing / slope - (crossing % slope < 0);    // floor: t * slope <= crossing
+    if (table->pid[loser] > table->pid[winner] || t * slope < crossing) {
+        t++;    // past the tie, or the tie itself goes to the loser's lower pid
+    }
+    return t < INT_MAX ? (int)t : INT_MAX;
+}
+
+// Replays the match at internal node at the queue's current time
+void settle_tournament_node(ReadyQueue* queue, int node) {
+    Tournament* tournament = queue->tournament;
+    int winners[2];
+    int expires = INT_MAX;
+    for (int side = 0; side < 2; side++) {
+        int child = 2 * node + side;
+        if (child >= tournament->size) {
+            winners[side] = (child - tournament->size < queue->count) ? child - tournament->size : -1;
+        }
+        else {
+            winners[side] = tournament->winner[child];
+            if (tournament->expires[child] < expires) {
+                expires = tournament->expires[child];
+            }
+        }
+    }
+    int winner = winners[0] >= 0 ? winners[0] : winners[1];
+    if (winners[0] >= 0 && winners[1] >= 0) {
+        int left = queue->items[winners[0]];
+        int right = queue->items[winners[1]];
+        COUNT_QUEUE(queue, candidates, 2);
+        bool left_first = ratio_before(queue->table, left, right, queue->now);
+        winner = left_first ? winners[0] : winners[1];
+        int overtake = left_first ? overtake_time(queue->table, left, right) : overtake_time(queue->table, right, left);
+        if (overtake < expires) {
+            expires = overtake;
+        }
+    }
+    tournament->winner[node] = winner;
+    tournament->expires[node] = expires;
+}
+
+// Replays the matches on the path from the leaf at position to the root
+void update_tournament(ReadyQueue* queue, int position) {
+    for (int node = (queue->tournament->size + position) / 2; node >= 1; node /= 2) {
+        settle_tournament_node(queue, node);
+    }
+}
+
+// Replays every match below node whose result may have changed by the queue's current time
+void refresh_tournament(ReadyQueue* queue, int node) {
+    Tournament* tournament = queue->tournament;
+    if (node >= tournament->size || tournament->expires[node] > queue->now) {
+        return;
+    }
+    refresh_tournament(queue, 2 * node);
+    refresh_tournament(queue, 2 * node + 1);
+    settle_tournament_node(queue, node);
+}
+
+// Sizes the tournament for at least size leaves (keeping its buffers when they are big enough)
+// and replays every match over the queue's current items
+void rebuild_tournament(ReadyQueue* queue, int size) {
+    Tournament* tournament = queue->tournament;
+    int leaves = 64;
+    while (leaves < size) {
+        leaves *= 2;
+    }
+    if (leaves > tournament->size) {
+        tournament->winner = grow_array(tournament->winner, leaves, sizeof(int));
+        tournament->expires = grow_array(tournament->expires, leaves, sizeof(int));
+        tournament->size = leaves;
+    }
+    for (int node = tournament->size - 1; node >= 1; node--) {
+        settle_tournament_node(queue, node);
+    }
+}
+
+// MLFQ priority boost: appends every lower level to level 0, keeping each level's FIFO order
+void boost_levels(ReadyQueue* queue) {
+    for (int level = 1; level < queue->num_levels; level++) {
+        for (int idx = queue->level_head[level]; idx >= 0; idx = queue->table->next_ready[idx]) {
+            queue->table->level[idx] = 0;
+        }
+        if (queue->level_head[level] < 0) {
+            continue;
+        }
+        if (queue->level_head[0] < 0) {
+            queue->level_head[0] = queue->level_head[level];
+        }
+        else {
+            queue->table->next_ready[queue->level_tail[0]] = queue->level_head[level];
+        }
+        queue->level_tail[0] = queue->level_tail[level];
+        queue->level_head[level] = -1;
+    }
+}
+
+// Masked argmin over the table: among processes with arrival_time <= arrival_limit that are not
+// completed, returns the index with the smallest key (largest for SELECT_PRIORITY), lowest index
+// on ties; -1 if there is none. Maximizing uses ~value, which reverses the order without overflow.
+int select_process(const ProcessTable* table, int num_processes, int arrival_limit, SelectKey key) {
+    const int* values = table->arrival_time;
+    if (key == SELECT_BURST) values = table->burst_time;
+    if (key == SELECT_REMAINING) values = table->remaining_time;
+    if (key == SELECT_PRIORITY) values = table->priority;
+    int flip = key == SELECT_PRIORITY ? -1 : 0;
+
+    int best = -1;
+    int best_value = INT_MAX;
+    int i = 0;
+
+#if defined(__AVX2__)
+    // 8 lanes per step; each lane keeps its own running best and the lanes are merged at the end
+    const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i flip_v = _mm256_set1_epi32(flip);
+    const __m256i limit_v = _mm256_set1_epi32(arrival_limit);
+    __m256i best_v = _mm256_set1_epi32(INT_MAX);
+    __m256i best_i = _mm256_set1_epi32(-1);
+    __m256i index_v = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    for (; i + 8 <= num_processes; i += 8) {
+        __m256i value = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&values[i]), flip_v);
+        __m256i arrival = _mm256_loadu_si256((const __m256i*)&table->arrival_time[i]);
+        int done = (int)((table->completed[i / 64] >> (i % 64)) & 0xff);
+        __m256i pending = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(done), lane_bits), _mm256_setzero_si256());
+        __m256i ready = _mm256_andnot_si256(_mm256_cmpgt_epi32(arrival, limit_v), pending);
+        // take the lane if it is strictly better, or equal to a lane that has no candidate yet
+        __m256i better = _mm256_or_si256(_mm256_cmpgt_epi32(best_v, value),
+            _mm256_and_si256(_mm256_cmpeq_epi32(best_v, value), _mm256_cmpeq_epi32(best_i, _mm256_set1_epi32(-1))));
+        __m256i take = _mm256_and_si256(ready, better);
+        best_v = _mm256_blendv_epi8(best_v, value, take);
+        best_i = _mm256_blendv_epi8(best_i, index_v, take);
+        index_v = _mm256_add_epi32(index_v, _mm256_set1_epi32(8));
+    }
+    int lane_value[8], lane_index[8];
+    _mm256_storeu_si256((__m256i*)lane_value, best_v);
+    _mm256_storeu_si256((__m256i*)lane_index, best_i);
+    for (int lane = 0; lane < 8; lane++) {
+        if (lane_index[lane] >= 0 && (best < 0 || lane_value[lane] < best_value || (lane_value[lane] == best_value && lane_index[lane] < best))) {
+            best = lane_index[lane];
+            best_value = lane_value[lane];
+        }
+    }
+#elif defined(__SSE2__)
+    // 4 lanes per step; SSE2 has no blend, so select with and/andnot/or
+    const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128i flip_v = _mm_set1_epi32(flip);
+    const __m128i limit_v = _mm_set1_epi32(arrival_limit);
+    __m128i best_v = _mm_set1_epi32(INT_MAX);
+    __m128i best_i = _mm_set1_epi32(-1);
+    __m128i index_v = _mm_setr_epi32(0, 1, 2, 3);
+    for (; i + 4 <= num_processes; i += 4) {
+        __m128i value = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&values[i]), flip_v);
+        __m128i arrival = _mm_loadu_si128((const __m128i*)&table->arrival_time[i]);
+        int done = (int)((table->completed[i / 64] >> (i % 64)) & 0xf);
+        __m128i pending = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(done), lane_bits), _mm_setzero_si128());
+        __m128i ready = _mm_andnot_si128(_mm_cmpgt_epi32(arrival, limit_v), pending);
+        __m128i better = _mm_or_si128(_mm_cmpgt_epi32(best_v, value),
+            _mm_and_si128(_mm_cmpeq_epi32(best_v, value), _mm_cmpeq_epi32(best_i, _mm_set1_epi32(-1))));
+        __m128i take = _mm_and_si128(ready, better);
+        best_v = _mm_or_si128(_mm_and_si128(take, value), _mm_andnot_si128(take, best_v));
+        best_i = _mm_or_si128(_mm_and_si128(take, index_v), _mm_andnot_si128(take, best_i));
+        index_v = _mm_add_epi32(index_v, _mm_set1_epi32(4));
+    }
+    int lane_value[4], lane_index[4];
+    _mm_storeu_si128((__m128i*)lane_value, best_v);
+    _mm_storeu_si128((__m128i*)lane_index, best_i);
+    for (int lane = 0; lane < 4; lane++) {
+        if (lane_index[lane] >= 0 && (best < 0 || lane_value[lane] < best_value || (lane_value[lane] == best_value && lane_index[lane] < best))) {
+            best = lane_index[lane];
+            best_value = lane_value[lane];
+        }
+    }
+#endif
+
+    // scalar fallback and tail; later indices only win when strictly better
+    for (; i < num_processes; i++) {
+        if (table->arrival_time[i] > arrival_limit || is_completed(table, i)) {
+            continue;
+        }
+        int value = values[i] ^ flip;
+        if (best < 0 || value < best_value) {
+            best = i;
+            best_value = value;
+        }
+    }
+    return best;
+}
+
+// Every engine buffer is allocated and grown by grow_array; the counters feed the benchmark
+atomic_llong allocation_count;
+atomic_llong allocated_bytes;
+
+// 배열을 capacity 크기로 다시 할당한다 (실패하면 종료)
+void* grow_array(void* items, int capacity, size_t item_size) {
+    atomic_fetch_add_explicit(&allocation_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&allocated_bytes, (long long)(item_size * (size_t)capacity), memory_order_relaxed);
+    void* grown = realloc(items, item_size * (size_t)capacity);
+    if (grown == NULL) {
+        perror("Unable to allocate memory");
+        exit(1);
+    }
+    return grown;
+}
+
+void reserve_processes(SimulationContext* ctx, int num_processes) {
+    if (num_processes > ctx->process_capacity) {
+        int capacity = ctx->process_capacity * 2;
+        if (capacity < num_processes) {
+            capacity = num_processes;
+        }
+        ProcessTable* table = &ctx->processes;
+        table->pid = grow_array(table->pid, capacity, sizeof(int));
+        table->arrival_time = grow_array(table->arrival_time, capacity, sizeof(int));
+        table->burst_time = grow_array(table->burst_time, capacity, sizeof(int));
+        table->remaining_time = grow_array(table->remaining_time, capacity, sizeof(int));
+        table->priority = grow_array(table->priority, capacity, sizeof(int));
+        table->completed = grow_array(table->completed, (capacity + 63) / 64, sizeof(uint64_t));
+        table->ready_time = grow_array(table->ready_time, capacity, sizeof(int));
+        table->pass = grow_array(table->pass, capacity, sizeof(long long));
+        table->age_origin = grow_array(table->age_origin, capacity, sizeof(int));
+        table->level = grow_array(table->level, capacity, sizeof(int));
+        table->next_ready = grow_array(table->next_ready, capacity, sizeof(int));
+        table->last_cpu = grow_array(table->last_cpu, capacity, sizeof(int));
+        table->phase = grow_array(table->phase, capacity, sizeof(int));
+        table->phase_remaining = grow_array(table->phase_remaining, capacity, sizeof(int));
+        table->num_bursts = grow_array(table->num_bursts, capacity, sizeof(int));
+        table->bursts = grow_array(table->bursts, capacity, sizeof(int) * MAX_BURSTS);
+        table->blocked_time = grow_array(table->blocked_time, capacity, sizeof(int));
+        table->response_time = grow_array(table->response_time, capacity, sizeof(int));
+        table->longest_wait = grow_array(table->longest_wait, capacity, sizeof(int));
+        table->waiting_time = grow_array(table->waiting_time, capacity, sizeof(int));
+        table->turnaround_time = grow_array(table->turnaround_time, capacity, sizeof(int));
+        table->completion_time = grow_array(table->completion_time, capacity, sizeof(int));
+        ctx->arrivals = grow_array(ctx->arrivals, capacity, sizeof(ArrivalEntry));
+        ctx->ready_items = grow_array(ctx->ready_items, capacity, sizeof(int));
+        ctx->process_capacity = capacity;
+    }
+    ctx->num_processes = num_processes;
+}
+
+bool is_completed(const ProcessTable* table, int idx) {
+    return (table->completed[idx / 64] >> (idx % 64)) & 1;
+}
+
+void set_completed(ProcessTable* table, int idx, bool completed) {
+    uint64_t bit = (uint64_t)1 << (idx % 64);
+    if (completed) {
+        table->completed[idx / 64] |= bit;
+    }
+    else {
+        table->completed[idx / 64] &= ~bit;
+    }
+}
+
+// Process 레코드를 표의 idx 번째 칸에 풀어 넣는다 (실행 상태는 초기화)
+void store_process(ProcessTable* table, int idx, const Process* process) {
+    table->pid[idx] = process->pid;
+    table->arrival_time[idx] = process->arrival_time;
+    table->burst_time[idx] = process->burst_time;
+    table->remaining_time[idx] = process->burst_time;
+    table->priority[idx] = process->priority;
+    set_completed(table, idx, false);
+    table->ready_time[idx] = process->arrival_time;
+    table->pass[idx] = 0;
+    table->age_origin[idx] = 0;
+    table->level[idx] = 0;
+    table->last_cpu[idx] = -1;
+    int* bursts = &table->bursts[idx * MAX_BURSTS];
+    if (process->num_bursts > 0) {
+        table->num_bursts[idx] = process->num_bursts;
+        memcpy(bursts, process->bursts, sizeof(int) * process->num_bursts);
+    }
+    else {
+        table->num_bursts[idx] = 1;
+        bursts[0] = process->burst_time;
+    }
+    table->phase[idx] = 0;
+    table->phase_remaining[idx] = bursts[0];
+    table->blocked_time[idx] = 0;
+    table->response_time[idx] = -1;
+    table->longest_wait[idx] = 0;
+    table->waiting_time[idx] = 0;
+    table->turnaround_time[idx] = 0;
+    table->completion_time[idx] = 0;
+}
+
+void load_workload(SimulationContext* ctx, const Process workload[], int num_processes) {
+    reserve_processes(ctx, num_processes);
+    for (int i = 0; i < num_processes; i++) {
+        store_process(&ctx->processes, i, &workload[i]);
+    }
+}
+
+void append_timeline(Timeline* timeline, int pid, int start, int end) {
+    if (timeline->size > 0) {
+        TimelineSegment* last = &timeline->segments[timeline->size - 1];
+        if (last->pid == pid && last->end == start) {
+            last->end = end;
+            return;
+        }
+    }
+
+    if (timeline->size == timeline->capacity) {
+        int capacity = (timeline->capacity > 0) ? timeline->capacity * 2 : 64;
+        timeline->segments = grow_array(timeline->segments, capacity, sizeof(TimelineSegment));
+        timeline->capacity = capacity;
+    }
+    timeline->segments[timeline->size].pid = pid;
+    timeline->segments[timeline->size].start = start;
+    timeline->segments[timeline->size++].end = end;
+}
+
+// Adds a run (or SWITCH_PID) segment on CPU lane to the Gantt timeline, if it is kept, and to the
+// Chrome trace, if the run is exported
+void record_segment(SimulationContext* ctx, Timeline* timeline, bool keep_timeline, int lane, int pid, int start, int end) {
+    if (keep_timeline) {
+        TIMED(&ctx->stats, PHASE_TIMELINE, append_timeline(timeline, pid, start, end));
+        COUNT(&ctx->stats, timeline_writes, 1);
+    }
+    if (ctx->trace_process > 0) {
+        TIMED(&ctx->stats, PHASE_TIMELINE, trace_run(ctx, lane, pid, start, end));
+    }
+}
+
+// Starts the run's Chrome trace events afresh, with num_lanes CPU lanes
+void start_trace_export(SimulationContext* ctx, int num_lanes) {
+    TraceExport* trace = &ctx->trace_export;
+    if (trace->events != NULL) {
+        fclose(trace->events);
+    }
+    trace->events = tmpfile();
+    if (trace->events == NULL) {
+        perror("Unable to open trace event file");
+        exit(1);
+    }
+    setvbuf(trace->events, NULL, _IOFBF, TRACE_BUFFER_SIZE);
+    if (trace->lane_capacity < num_lanes) {
+        trace->pending = grow_array(trace->pending, num_lanes, sizeof(TimelineSegment));
+        trace->lane_capacity = num_lanes;
+    }
+    trace->num_lanes = num_lanes;
+    for (int lane = 0; lane < num_lanes; lane++) {
+        trace->pending[lane].end = -1;
+    }
+}
+
+// Extends the lane's held-back segment, or writes it out and holds back this one instead
+void trace_run(SimulationContext* ctx, int lane, int pid, int start, int end) {
+    TimelineSegment* pending = &ctx->trace_export.pending[lane];
+    if (pending->end == start && pending->pid == pid) {
+        pending->end = end;
+        return;
+    }
+    if (pending->end >= 0) {
+        write_trace_segment(ctx, lane, pending);
+    }
+    pending->pid = pid;
+    pending->start = start;
+    pending->end = end;
+}
+
+// One simulated time unit is one microsecond of trace time, so timestamps are the simulated times
+// and idle stretches show as gaps in the lane
+void write_trace_segment(SimulationContext* ctx, int lane, const TimelineSegment* segment) {
+    FILE* fp = ctx->trace_export.events;
+    if (segment->pid == SWITCH_PID) {
+        fprintf(fp, ",\n{\"name\":\"Context Switch\",\"cat\":\"switch\",\"ph\":\"X\",\"ts\":%d,\"dur\":%d,\"pid\":%d,\"tid\":%d}",
+            segment->start, segment->end - segment->start, ctx->trace_process, lane + 1);
+    }
+    else {
+        fprintf(fp, ",\n{\"name\":\"P%d\",\"cat\":\"run\",\"ph\":\"X\",\"ts\":%d,\"dur\":%d,\"pid\":%d,\"tid\":%d,\"args\":{\"pid\":%d}}",
+            segment->pid, segment->start, segment->end - segment->start, ctx->trace_process, lane + 1, segment->pid);
+    }
+}
+
+// Writes an instant event ("Arrive", "Complete" or "Preempt") for process pid on a lane
+void trace_instant(SimulationContext* ctx, int lane, const char* name, int pid, int time) {
+    fprintf(ctx->trace_export.events, ",\n{\"name\":\"%s P%d\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%d,\"pid\":%d,\"tid\":%d,\"args\":{\"pid\":%d}}",
+        name, pid, name, time, ctx->trace_process, lane + 1, pid);
+}
+
+// Writes out the segments still held back at the end of the run
+void finish_trace_export(SimulationContext* ctx) {
+    TraceExport* trace = &ctx->trace_export;
+    for (int lane = 0; lane < trace->num_lanes; lane++) {
+        if (trace->pending[lane].end >= 0) {
+            write_trace_segment(ctx, lane, &trace->pending[lane]);
+            trace->pending[lane].end = -1;
+        }
+    }
+}
+
+// Writes filename as one Chrome Trace Event JSON file (chrome://tracing, ui.perfetto.dev): one
+// trace process per algorithm in the given order, with a thread for arrivals and completions and
+// one per CPU, followed by every run's events
+int write_chrome_trace(const char* filename, SimulationContext contexts[], int num_contexts) {
+    FILE* fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        perror(filename);
+        return 1;
+    }
+    setvbuf(fp, NULL, _IOFBF, 1 << 20);
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    for (int i = 0; i < num_contexts; i++) {
+        const TraceExport* trace = &contexts[i].trace_export;
+        int process = contexts[i].trace_process;
+        if (trace->events == NULL) {
+            continue;
+        }
+        fprintf(fp, "%s\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",", process, contexts[i].algorithm_name);
+        fprintf(fp, ",\n{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"sort_index\":%d}}", process, process);
+        fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"Jobs\"}}", process);
+        for (int lane = 0; lane < trace->num_lanes; lane++) {
+            fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"CPU %d\"}}", process, lane + 1, lane);
+        }
+        first = false;
+    }
+    // every event starts with its separator, so the runs' files are simply appended
+    int status = 0;
+    for (int i = 0; i < num_contexts; i++) {
+        if (contexts[i].trace_export.events != NULL && !copy_file(contexts[i].trace_export.events, fp)) {
+            perror(filename);
+            status = 1;
+        }
+    }
+    fprintf(fp, "\n]}\n");
+    if (fclose(fp) != 0) {
+        perror(filename);
+        status = 1;
+    }
+    return status;
+}
+
+void free_simulation_context(SimulationContext* ctx) {
+    free(ctx->processes.pid);
+    free(ctx->processes.arrival_time);
+    free(ctx->processes.burst_time);
+    free(ctx->processes.remaining_time);
+    free(ctx->processes.priority);
+    free(ctx->processes.completed);
+    free(ctx->processes.ready_time);
+    free(ctx->processes.pass);
+    free(ctx->processes.age_origin);
+    free(ctx->processes.level);
+    free(ctx->processes.next_ready);
+    free(ctx->processes.last_cpu);
+    free(ctx->processes.phase);
+    free(ctx->processes.phase_remaining);
+    free(ctx->processes.num_bursts);
+    free(ctx->processes.bursts);
+    free(ctx->processes.blocked_time);
+    free(ctx->processes.response_time);
+    free(ctx->processes.longest_wait);
+    free(ctx->device.queue.items);
+    free(ctx->processes.waiting_time);
+    free(ctx->processes.turnaround_time);
+    free(ctx->processes.completion_time);
+    free(ctx->arrivals);
+    free(ctx->ready_items);
+    free(ctx->free_slots);
+    free(ctx->timeline.segments);
+    free(ctx->tournament.winner);
+    free(ctx->tournament.expires);
+    if (ctx->trace_export.events != NULL) {
+        fclose(ctx->trace_export.events);
+    }
+    free(ctx->trace_export.pending);
+    for (int i = 0; i < ctx->checkpoint_capacity; i++) {
+        free(ctx->checkpoints[i].queue_items);
+        free(ctx->checkpoints[i].device_items);
+        free(ctx->checkpoints[i].live);
+        for (int metric = 0; metric < NUM_LATENCY_METRICS; metric++) {
+            free(ctx->checkpoints[i].latency[metric].counts);
+        }
+    }
+    free(ctx->checkpoints);
+    for (int metric = 0; metric < NUM_LATENCY_METRICS; metric++) {
+        free(ctx->latency[metric].counts);
+    }
+    for (int k = 0; k < RESULT_COLUMNS; k++) {
+        free(ctx->results.columns[k]);
+    }
+    reset_results(&ctx->results);
+    for (int c = 0; c < ctx->num_cpus; c++) {
+        free(ctx->cpus[c].queue.items);
+        free(ctx->cpus[c].timeline.segments);
+        free(ctx->cpus[c].tournament.winner);
+        free(ctx->cpus[c].tournament.expires);
+    }
+    free(ctx->cpus);
+}
+
+void apply_options(SimulationContext* ctx, const SimulationOptions* options) {
+    ctx->smp = options->smp;
+    ctx->io_discipline = options->io_discipline;
+    ctx->dispatch_latency = options->dispatch_latency;
+    ctx->switch_cost = options->switch_cost;
+    ctx->aging_interval = options->aging_interval;
+    ctx->result_format = options->result_format;
+    ctx->verbosity = options->verbosity;
+}
+
+// 라벨 줄과 시각 줄의 칸 너비를 맞추기 위해 둘 중 긴 쪽에 맞춰 출력한다
+void print_gantt_cell(FILE* out, const char* label, int start, bool stamp_row) {
+    char stamp[16];
+    snprintf(stamp, sizeof(stamp), "%d", start);
+
+    int width = (int)(strlen(label) > strlen(stamp) ? strlen(label) : strlen(stamp)) + 1;
+    fprintf(out, "%-*s", width, stamp_row ? stamp : label);
+}
+
+// 구간마다 한 칸씩 출력하고 아래 줄에 각 구간의 시작 시각을 찍는다 (CPU가 쉬는 구간은 Idle, 문맥 교환은 CS)
+void print_gantt_chart(FILE* out, const char* title, TimelineSegment timeline[], int timeline_size) {
+    if (out == NULL) {
+        return;
+    }
+    fprintf(out, "\n%s:\n", title);
+    if (timeline_size == 0) {
+        return;
+    }
+
+    char label[16];
+    for (int row = 0; row < 2; row++) {
+        int previous_end = timeline[0].start;
+        for (int i = 0; i < timeline_size; i++) {
+            if (timeline[i].start > previous_end) {
+                print_gantt_cell(out, "Idle", previous_end, row == 1);
+            }
+            if (timeline[i].pid == SWITCH_PID) {
+                snprintf(label, sizeof(label), "CS");
+            }
+            else {
+                snprintf(label, sizeof(label), "P%d", timeline[i].pid);
+            }
+            print_gantt_cell(out, label, timeline[i].start, row == 1);
+            previous_end = timeline[i].end;
+        }
+        if (row == 1) {
+            fprintf(out, "%d", previous_end);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+int default_thread_count(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus > 0) ? (int)cpus : 1;
+}
+
+void* task_pool_worker(void* arg) {
+    TaskPool* pool = (TaskPool*)arg;
+
+    while (true) {
+        pthread_mutex_lock(&pool->lock);
+        int index = pool->next_task++;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (index >= pool->num_tasks) {
+            break;
+        }
+        pool->task(pool->arg, index);
+    }
+    return NULL;
+}
+
+// task(arg, 0..num_tasks-1) 를 num_threads 개의 스레드에 나눠 실행하고 모두 끝날 때까지 기다린다
+void run_parallel(int num_tasks, int num_threads, void (*task)(void* arg, int index), void* arg) {
+    TaskPool pool = { task, arg, num_tasks, 0, PTHREAD_MUTEX_INITIALIZER };
+
+    if (num_threads > num_tasks) {
+        num_threads = num_tasks;
+    }
+    pthread_t* threads = malloc(sizeof(pthread_t) * (num_threads > 0 ? num_threads : 1));
+    int started = 0;
+    if (threads != NULL) {
+        for (; started < num_threads; started++) {
+            if (pthread_create(&threads[started], NULL, task_pool_worker, &pool) != 0) {
+                break;
+            }
+        }
+    }
+    // Runs on the calling thread too, so the tasks complete even if no thread could be started
+    task_pool_worker(&pool);
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&pool.lock);
+}
+
+// Every algorithm, in report order
+const Algorithm algorithms[NUM_ALGORITHMS] = {
+    { fcfs_scheduling, "FCFS" },
+    { non_preemptive_sjf, "Non-Preemptive SJF" },
+    { preemptive_sjf, "Preemptive SJF" },
+    { non_preemptive_priority, "Non-Preemptive Priority" },
+    { preemptive_priority, "Preemptive Priority" },
+    { round_robin_default, "Round Robin" },
+    { mlfq_default, "MLFQ" },
+    { hrrn_scheduling, "HRRN" },
+    { stride_scheduling, "Stride" }
+};
+
+// Runs algorithm index on ctx under its name
+void run_algorithm(SimulationContext* ctx, int index) {
+    ctx->algorithm_name = algorithms[index].name;
+    algorithms[index].run(ctx);
+}
+
+const LoadBalancer load_balancers[NUM_LOAD_BALANCERS] = {
+    { "steal", place_least_loaded, steal_busiest },
+    { "least-loaded", place_least_loaded, NULL },
+    { "static", place_by_pid, NULL }
+};
+
+const LoadBalancer* find_load_balancer(const char* name) {
+    for (int i = 0; i < NUM_LOAD_BALANCERS; i++) {
+        if (strcmp(load_balancers[i].name, name) == 0) {
+            return &load_balancers[i];
+        }
+    }
+    return NULL;
+}
+
+void run_algorithm_task(void* arg, int index) {
+    SimulationContext* contexts = (SimulationContext*)arg;
+    run_algorithm(&contexts[index], index);
+}
+
+int compare_double(const void* a, const void* b) {
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+
+    if (da < db) return -1;
+    if (da > db) return 1;
+    return 0;
+}
+
+// 평균, 표준편차(표본), nearest-rank 백분위수. samples 는 정렬된다
+void summarize_samples(double samples[], int count, SampleSummary* summary) {
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    summary->mean = sum / count;
+
+    double squares = 0.0;
+    for (int i = 0; i < count; i++) {
+        squares += (samples[i] - summary->mean) * (samples[i] - summary->mean);
+    }
+    summary->stddev = (count > 1) ? sqrt(squares / (count - 1)) : 0.0;
+
+    qsort(samples, count, sizeof(double), compare_double);
+    summary->p50 = samples[(int)ceil(0.50 * count) - 1];
+    summary->p90 = samples[(int)ceil(0.90 * count) - 1];
+    summary->p99 = samples[(int)ceil(0.99 * count) - 1];
+}
+
+// Per-trial values the sweep summarizes for every algorithm
+const char* const sweep_metric_names[NUM_SWEEP_METRICS] = {
+    "Waiting",
+    "Turnaround",
+    "Context Switches",
+    "Switch Overhead",
+    "CPU Utilization"
+};
+
+// One trial: a fresh workload from the trial's own seed, scheduled by every algorithm without
+// any report output. The seed depends only on (sweep seed, trial), so results do not depend on
+// which thread runs the trial.
+void run_sweep_trial(void* arg, int trial) {
+    SweepState* sweep = (SweepState*)arg;
+    SimulationContext ctx = { 0 };
+    apply_options(&ctx, sweep->options);
+    uint64_t trial_seed = sweep->seed + (uint64_t)trial;
+
+    Process* workload = grow_array(NULL, sweep->num_processes, sizeof(Process));
+    generate_processes(workload, sweep->num_processes, next_random(&trial_seed), sweep->options->with_io);
+
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        load_workload(&ctx, workload, sweep->num_processes);
+        run_algorithm(&ctx, i);
+        double values[NUM_SWEEP_METRICS] = {
+            ctx.avg_waiting_time,
+            ctx.avg_turnaround_time,
+            (double)ctx.context_switches,
+            (double)ctx.switch_overhead,
+            total_cpu_utilization(&ctx)
+        };
+        for (int metric = 0; metric < NUM_SWEEP_METRICS; metric++) {
+            sweep->samples[metric][trial * NUM_ALGORITHMS + i] = values[metric];
+        }
+    }
+
+    free(workload);
+    free_simulation_context(&ctx);
+}
+
+int run_sweep(int num_trials, int num_processes, uint64_t seed, const SimulationOptions* options) {
+    SweepState sweep = { num_trials, num_processes, seed, { NULL }, options };
+    for (int metric = 0; metric < NUM_SWEEP_METRICS; metric++) {
+        sweep.samples[metric] = grow_array(NULL, num_trials * NUM_ALGORITHMS, sizeof(double));
+    }
+
+    run_parallel(num_trials, default_thread_count(), run_sweep_trial, &sweep);
+
+    FILE* fp = fopen("sweep_results.csv", "w");
+    if (fp == NULL) {
+        perror("Unable to open file");
+    }
+    else {
+        fprintf(fp, "Algorithm,Metric,Mean,StdDev,P50,P90,P99\n");
+    }
+
+    bool report = VERBOSE(options->verbosity, VERBOSITY_SUMMARY);
+    if (report) {
+        printf("Monte Carlo sweep: %d trials x %d processes, seed %llu\n", num_trials, num_processes, (unsigned long long)seed);
+        printf("%-24s %-16s %9s %9s %9s %9s %9s\n", "Algorithm", "Metric", "Mean", "StdDev", "P50", "P90", "P99");
+    }
+
+    double* samples = grow_array(NULL, num_trials, sizeof(double));
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        for (int metric = 0; metric < NUM_SWEEP_METRICS; metric++) {
+            const double* values = sweep.samples[metric];
+            const char* metric_name = sweep_metric_names[metric];
+            for (int trial = 0; trial < num_trials; trial++) {
+                samples[trial] = values[trial * NUM_ALGORITHMS + i];
+            }
+
+            SampleSummary summary;
+            summarize_samples(samples, num_trials, &summary);
+            if (report) {
+                printf("%-24s %-16s %9.2f %9.2f %9.2f %9.2f %9.2f\n", algorithms[i].name, metric_name,
+                    summary.mean, summary.stddev, summary.p50, summary.p90, summary.p99);
+            }
+            if (fp != NULL) {
+                fprintf(fp, "%s,%s,%.4f,%.4f,%.4f,%.4f,%.4f\n", algorithms[i].name, metric_name,
+                    summary.mean, summary.stddev, summary.p50, summary.p90, summary.p99);
+            }
+        }
+    }
+
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    free(samples);
+    for (int metric = 0; metric < NUM_SWEEP_METRICS; metric++) {
+        free(sweep.samples[metric]);
+    }
+    return 0;
+}
+
+// Replays a CSV trace or binary workload file with every algorithm, printing only the
+// per-algorithm summary. Each run streams a CSV trace on its own; a binary workload is mapped
+// once and shared read-only by all runs.
+int run_trace(const char* filename, const SimulationOptions* options) {
+    SimulationContext contexts[NUM_ALGORITHMS] = { 0 };
+    MappedWorkload workload = { 0 };
+    bool binary = is_workload_file(filename);
+    if (binary && !map_workload(&workload, filename)) {
+        return 1;
+    }
+
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        apply_options(&contexts[i], options);
+        contexts[i].trace_process = (options->chrome_trace != NULL) ? i + 1 : 0;
+        // Every run reads the whole trace and fails the same way, so only the first reports it
+        contexts[i].quiet_trace_errors = i > 0;
+        if (binary) {
+            contexts[i].workload_map = &workload;
+        }
+        else {
+            contexts[i].trace_filename = filename;
+        }
+    }
+
+    run_parallel(NUM_ALGORITHMS, default_thread_count(), run_algorithm_task, contexts);
+    unmap_workload(&workload);
+
+    int status = 0;
+    bool report = VERBOSE(options->verbosity, VERBOSITY_SUMMARY);
+    if (report) {
+        printf("Trace: %s\n", filename);
+    }
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        if (contexts[i].trace_failed) {
+            status = 1;
+        }
+        if (!report) {
+            continue;
+        }
+        printf("%-24s Processes: %lld, Average Waiting Time: %.2f, Average Turnaround Time: %.2f\n",
+            contexts[i].algorithm_name, contexts[i].num_completed, contexts[i].avg_waiting_time, contexts[i].avg_turnaround_time);
+        printf("%-24s Context Switches: %lld, Switch Overhead: %lld, Effective CPU Utilization: %.1f%%\n", "",
+            contexts[i].context_switches, contexts[i].switch_overhead, total_cpu_utilization(&contexts[i]));
+        printf("%-24s", "");
+        for (int metric = 0; metric < NUM_LATENCY_METRICS; metric++) {
+            printf("%s P99 %s: %.2f", metric > 0 ? "," : "", latency_metric_names[metric],
+                latency_value(metric, histogram_percentile(&contexts[i].latency[metric], 99.0)));
+        }
+        printf("\n");
+        if (options->smp != NULL) {
+            printf("%-24s CPU Utilization:", "");
+            for (int c = 0; c < options->smp->num_cpus; c++) {
+                printf(" %.1f%%", cpu_utilization(&contexts[i], c));
+            }
+            printf("\n");
+        }
+        if (contexts[i].io_requests > 0) {
+            printf("%-24s I/O Requests: %lld, I/O Device Utilization: %.1f%%\n", "",
+                contexts[i].io_requests, device_utilization(&contexts[i]));
+        }
+    }
+
+    if (write_results(contexts, NUM_ALGORITHMS, options->result_format) != 0) {
+        status = 1;
+    }
+    if (options->chrome_trace != NULL && write_chrome_trace(options->chrome_trace, contexts, NUM_ALGORITHMS) != 0) {
+        status = 1;
+    }
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        free_simulation_context(&contexts[i]);
+    }
+    return status;
+}
+
+bool same_job(const Process* a, const Process* b) {
+    if (a->pid != b->pid || a->arrival_time != b->arrival_time || a->burst_time != b->burst_time
+        || a->priority != b->priority || a->num_bursts != b->num_bursts) {
+        return false;
+    }
+    return memcmp(a->bursts, b->bursts, sizeof(int) * a->num_bursts) == 0;
+}
+
+// Schedules the base workload, saving checkpoints as it goes
+void run_what_if_base_task(void* arg, int index) {
+    WhatIfState* what_if = (WhatIfState*)arg;
+    SimulationContext* ctx = &what_if->contexts[index];
+    ctx->checkpointing = true;
+    load_workload(ctx, what_if->base, what_if->num_base);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    run_algorithm(ctx, index);
+    what_if->base_seconds[index] = elapsed_seconds(&start);
+    what_if->base_waiting_times[index] = ctx->avg_waiting_time;
+    what_if->base_turnaround_times[index] = ctx->avg_turnaround_time;
+    what_if->replaced_from[index] = what_if->num_base;
+    ctx->checkpointing = false;
+}
+
+// Schedules the current edited workload from the latest base checkpoint that had admitted no
+// changed job and was taken before any changed arrival. Up to that point both runs make the same
+// decisions: every earlier slice ended before the change could cut it. The replay saves no
+// checkpoints of its own, so the base ones stay valid for the next query.
+void run_what_if_task(void* arg, int index) {
+    WhatIfState* what_if = (WhatIfState*)arg;
+    SimulationContext* ctx = &what_if->contexts[index];
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    Checkpoint* resume = NULL;
+    for (int k = ctx->num_checkpoints - 1; k >= 0 && resume == NULL; k--) {
+        const Checkpoint* checkpoint = &ctx->checkpoints[k];
+        if (checkpoint->num_admitted <= what_if->first_changed && checkpoint->current_time < what_if->change_time) {
+            resume = &ctx->checkpoints[k];
+        }
+    }
+    int first = (resume != NULL) ? resume->num_admitted : 0;
+    reserve_processes(ctx, what_if->num_edited);
+    // Entries an earlier query overwrote before the checkpoint get their base jobs back: each had
+    // completed by then or is live in the checkpoint, which restores it
+    for (int i = what_if->replaced_from[index]; i < first; i++) {
+        store_process(&ctx->processes, i, &what_if->base[i]);
+        set_completed(&ctx->processes, i, true);
+    }
+    for (int i = first; i < what_if->num_edited; i++) {
+        store_process(&ctx->processes, i, &what_if->edited[i]);
+    }
+    if (first < what_if->replaced_from[index]) {
+        what_if->replaced_from[index] = first;
+    }
+    ctx->resume = resume;
+    what_if->resume_times[index] = (resume != NULL) ? resume->current_time : 0;
+    run_algorithm(ctx, index);
+    what_if->replay_seconds[index] = elapsed_seconds(&start);
+}
+
+// Compares edited traces with their base: every algorithm schedules the base trace once, then
+// for each edited trace replays only the part of the schedule its edit can change. Traces are
+// loaded into memory and simulated on one CPU. Each query's time covers loading and comparing
+// its trace as well as the replays; the edited results go to scheduling_results.csv, one row
+// per trace and algorithm.
+int run_what_if(const char* base_filename, char* const edited_filenames[], int num_edited_files, const SimulationOptions* options) {
+    if (options->smp != NULL) {
+        fprintf(stderr, "--what-if simulates one CPU\n");
+        return 1;
+    }
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    WhatIfState what_if = { 0 };
+    Process* base = read_workload(base_filename, &what_if.num_base);
+    if (base == NULL) {
+        return 1;
+    }
+    what_if.base = base;
+
+    SimulationContext contexts[NUM_ALGORITHMS] = { 0 };
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        apply_options(&contexts[i], options);
+        contexts[i].result_format = RESULTS_NONE;
+    }
+    what_if.contexts = contexts;
+    run_parallel(NUM_ALGORITHMS, default_thread_count(), run_what_if_base_task, &what_if);
+
+    bool report = VERBOSE(options->verbosity, VERBOSITY_SUMMARY);
+    if (report) {
+        printf("What-if base: %s (%d jobs, %.6f s)\n", base_filename, what_if.num_base, elapsed_seconds(&start));
+        for (int i = 0; i < NUM_ALGORITHMS; i++) {
+            printf("%-24s Base Average Waiting Time: %.2f, Average Turnaround Time: %.2f (%.6f s)\n", contexts[i].algorithm_name,
+                what_if.base_waiting_times[i], what_if.base_turnaround_times[i], what_if.base_seconds[i]);
+        }
+    }
+
+    int status = 0;
+    FILE* fp = fopen("scheduling_results.csv", "w");
+    if (fp == NULL) {
+        perror("scheduling_results.csv");
+        status = 1;
+    }
+    else {
+        fprintf(fp, "Trace,");
+        write_summary_header(fp);
+    }
+
+    for (int q = 0; q < num_edited_files; q++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        Process* edited = read_workload(edited_filenames[q], &what_if.num_edited);
+        if (edited == NULL) {
+            status = 1;
+            continue;
+        }
+        what_if.edited = edited;
+
+        int shorter = (what_if.num_base < what_if.num_edited) ? what_if.num_base : what_if.num_edited;
+        int first = 0;
+        while (first < shorter && same_job(&base[first], &edited[first])) {
+            first++;
+        }
+        what_if.first_changed = first;
+        what_if.change_time = INT_MAX;
+        if (first < what_if.num_base) {
+            what_if.change_time = base[first].arrival_time;
+        }
+        if (first < what_if.num_edited && edited[first].arrival_time < what_if.change_time) {
+            what_if.change_time = edited[first].arrival_time;
+        }
+
+        run_parallel(NUM_ALGORITHMS, default_thread_count(), run_what_if_task, &what_if);
+        double query_seconds = elapsed_seconds(&start);
+
+        if (report) {
+            printf("What-if: %s (%d jobs, %.6f s): ", edited_filenames[q], what_if.num_edited, query_seconds);
+            if (what_if.change_time == INT_MAX) {
+                printf("no job changed\n");
+            }
+            else {
+                printf("first change job %d, t=%d\n", first + 1, what_if.change_time);
+            }
+            for (int i = 0; i < NUM_ALGORITHMS; i++) {
+                printf("%-24s Edited Average Waiting Time: %.2f, Average Turnaround Time: %.2f (resumed at t=%d, %.6f s)\n", contexts[i].algorithm_name,
+                    contexts[i].avg_waiting_time, contexts[i].avg_turnaround_time, what_if.resume_times[i], what_if.replay_seconds[i]);
+            }
+        }
+        for (int i = 0; i < NUM_ALGORITHMS && fp != NULL; i++) {
+            fprintf(fp, "%s,", edited_filenames[q]);
+            write_summary_row(fp, &contexts[i]);
+        }
+        free(edited);
+    }
+
+    if (fp != NULL && fclose(fp) != 0) {
+        perror("scheduling_results.csv");
+        status = 1;
+    }
+#if INSTRUMENTATION
+    if (write_instrumentation(contexts, NUM_ALGORITHMS, 0) != 0) {
+        status = 1;
+    }
+#endif
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        free_simulation_context(&contexts[i]);
+    }
+    free(base);
+    return status;
+}
+
+// Uniform in (0, 1]
+double random_unit(uint64_t* state) {
+    return (double)((next_random(state) >> 11) + 1) * 0x1.0p-53;
+}
+
+// Gaps of 0..12 and bursts of 1..10, the distribution --generate writes
+void bench_uniform(uint64_t* state, long long index, int* interarrival, int* burst) {
+    (void)index;
+    *interarrival = (int)(next_random(state) % 13);
+    *burst = (int)(next_random(state) % 10) + 1;
+}
+
+// Poisson arrivals (mean gap 6) with exponential bursts (mean about 5)
+void bench_exponential(uint64_t* state, long long index, int* interarrival, int* burst) {
+    (void)index;
+    *interarrival = (int)(-6.0 * log(random_unit(state)));
+    *burst = 1 + (int)(-4.5 * log(random_unit(state)));
+}
+
+// Poisson arrivals with Pareto bursts (alpha 1.5, at least 1, capped at 100000): mostly short
+// jobs and a few very long ones
+void bench_heavy_tail(uint64_t* state, long long index, int* interarrival, int* burst) {
+    (void)index;
+    *interarrival = (int)(-6.0 * log(random_unit(state)));
+    double pareto = pow(random_unit(state), -1.0 / 1.5);
+    *burst = pareto < 100000.0 ? (int)pareto : 100000;
+}
+
+// Batches of 100 jobs arriving together every 600 time units, bursts of 1..10
+void bench_batches(uint64_t* state, long long index, int* interarrival, int* burst) {
+    *interarrival = (index % 100 == 0 && index > 0) ? 600 : 0;
+    *burst = (int)(next_random(state) % 10) + 1;
+}
+
+const BenchDistribution bench_distributions[NUM_BENCH_DISTRIBUTIONS] = {
+    { "uniform", bench_uniform },
+    { "exponential", bench_exponential },
+    { "heavy-tail", bench_heavy_tail },
+    { "batches", bench_batches }
+};
+
+// Arrival-sorted CPU-only records, laid out like a mapped binary workload
+void generate_records(WorkloadRecord records[], long long num_records, uint64_t seed, const BenchDistribution* distribution) {
+    uint64_t state = seed;
+    int arrival_time = 0;
+    for (long long i = 0; i < num_records; i++) {
+        int interarrival;
+        int burst;
+        distribution->next_job(&state, i, &interarrival, &burst);
+        arrival_time = (interarrival < INT_MAX - arrival_time) ? arrival_time + interarrival : INT_MAX - 1;
+        records[i].pid = (int32_t)(i + 1);
+        records[i].arrival_time = arrival_time;
+        records[i].burst_time = burst;
+        records[i].priority = (int32_t)(next_random(&state) % 10) + 1;
+        records[i].io_burst_time = 0;
+    }
+}
+
+double elapsed_seconds(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+// Linux lets a process reset its peak RSS; elsewhere the peak only ever grows. glibc keeps freed
+// heap pages resident, so they are released first: the new peak starts from live memory only.
+void reset_peak_rss(void) {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+    FILE* fp = fopen("/proc/self/clear_refs", "w");
+    if (fp != NULL) {
+        fputs("5", fp);
+        fclose(fp);
+    }
+}
+
+long peak_rss_kb(void) {
+    long peak = -1;
+    char line[128];
+    FILE* fp = fopen("/proc/self/status", "r");
+    if (fp != NULL) {
+        while (fgets(line, sizeof(line), fp) != NULL) {
+            if (strncmp(line, "VmHWM:", 6) == 0) {
+                peak = atol(line + 6);
+                break;
+            }
+        }
+        fclose(fp);
+    }
+    if (peak < 0) {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        peak = usage.ru_maxrss;
+    }
+    return peak;
+}
+
+// Times every algorithm, one at a time, on each distribution at sizes 10, 100, ..., max_processes.
+// Workloads are generated in memory and streamed to the engine like a mapped binary workload, so
+// the process table holds only live jobs. Events are arrivals, dispatches and completions. Peak
+// RSS covers the whole process, the case's workload included; every case allocates and frees its
+// own, so a larger earlier case does not show up in later ones. Allocations count grow_array calls.
+// Results go to benchmark_results.csv.
+int run_benchmark(long long max_processes, uint64_t seed, const SimulationOptions* options) {
+    FILE* fp = fopen("benchmark_results.csv", "w");
+    if (fp == NULL) {
+        perror("benchmark_results.csv");
+        return 1;
+    }
+    fprintf(fp, "Distribution,Processes,Algorithm,Seconds,Events,Events Per Second,Peak RSS KB,Allocations,Allocated Bytes\n");
+
+    bool report = VERBOSE(options->verbosity, VERBOSITY_SUMMARY);
+    if (report) {
+        printf("Benchmark: up to %lld processes, seed %llu\n", max_processes, (unsigned long long)seed);
+        printf("%-12s %9s %-24s %10s %12s %12s %10s %8s\n", "Distribution", "Processes", "Algorithm",
+            "Seconds", "Events", "Events/s", "Peak RSS", "Allocs");
+    }
+
+    for (int d = 0; d < NUM_BENCH_DISTRIBUTIONS; d++) {
+        for (long long n = 10; n <= max_processes; n *= 10) {
+            WorkloadRecord* records = grow_array(NULL, (int)n, sizeof(WorkloadRecord));
+            generate_records(records, n, seed, &bench_distributions[d]);
+            MappedWorkload workload = { NULL, 0, records, n };
+
+            for (int i = 0; i < NUM_ALGORITHMS; i++) {
+                SimulationContext ctx = { 0 };
+                apply_options(&ctx, options);
+                ctx.workload_map = &workload;
+
+                reset_peak_rss();
+                long long allocations = atomic_load(&allocation_count);
+                long long bytes = atomic_load(&allocated_bytes);
+                struct timespec start;
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                run_algorithm(&ctx, i);
+                double seconds = elapsed_seconds(&start);
+                long peak_rss = peak_rss_kb();
+                allocations = atomic_load(&allocation_count) - allocations;
+                bytes = atomic_load(&allocated_bytes) - bytes;
+
+                long long events = 2 * ctx.num_completed + ctx.dispatches;
+                double events_per_second = seconds > 0.0 ? events / seconds : 0.0;
+                if (report) {
+                    printf("%-12s %9lld %-24s %10.6f %12lld %12.0f %7ld KB %8lld\n", bench_distributions[d].name, n,
+                        algorithms[i].name, seconds, events, events_per_second, peak_rss, allocations);
+                }
+                fprintf(fp, "%s,%lld,%s,%.6f,%lld,%.0f,%ld,%lld,%lld\n", bench_distributions[d].name, n,
+                    algorithms[i].name, seconds, events, events_per_second, peak_rss, allocations, bytes);
+                free_simulation_context(&ctx);
+            }
+            free(records);
+        }
+    }
+
+    if (fclose(fp) != 0) {
+        perror("benchmark_results.csv");
+        return 1;
+    }
+    return 0;
+}
+
+#if INSTRUMENTATION
+#if defined(__x86_64__) || defined(__i386__)
+#define CYCLE_UNIT "tsc"
+#else
+#define CYCLE_UNIT "ns"
+#endif
+
+// Time stamp counter on x86, monotonic nanoseconds elsewhere
+uint64_t read_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+const char* const phase_names[NUM_PHASES] = { "engine", "admit", "select", "timeline", "report", "export" };
+
+// Dumps every run's counters and phase timings to instrumentation.json; export_cycles is the
+// time spent writing the per-process result files for all runs
+int write_instrumentation(const SimulationContext contexts[], int num_contexts, uint64_t export_cycles) {
+    FILE* fp = fopen("instrumentation.json", "w");
+    if (fp == NULL) {
+        perror("instrumentation.json");
+        return 1;
+    }
+    fprintf(fp, "{\n  \"timer\": \"%s\",\n  \"process_results_cycles\": %llu,\n  \"algorithms\": [", CYCLE_UNIT, (unsigned long long)export_cycles);
+    for (int i = 0; i < num_contexts; i++) {
+        const Instrumentation* stats = &contexts[i].stats;
+        fprintf(fp, "%s\n    {\n      \"name\": \"%s\",\n", i > 0 ? "," : "", contexts[i].algorithm_name != NULL ? contexts[i].algorithm_name : "");
+        fprintf(fp, "      \"decisions\": %lld,\n      \"candidates\": %lld,\n      \"preemptions\": %lld,\n",
+            stats->decisions, stats->candidates, stats->preemptions);
+        fprintf(fp, "      \"enqueues\": %lld,\n      \"dequeues\": %lld,\n      \"timeline_writes\": %lld,\n",
+            stats->enqueues, stats->dequeues, stats->timeline_writes);
+        fprintf(fp, "      \"phases\": {");
+        for (int phase = 0; phase < NUM_PHASES; phase++) {
+            fprintf(fp, "%s\n        \"%s\": { \"calls\": %lld, \"cycles\": %llu }", phase > 0 ? "," : "", phase_names[phase],
+                stats->phase_calls[phase], (unsigned long long)stats->phase_cycles[phase]);
+        }
+        fprintf(fp, "\n      }\n    }");
+    }
+    fprintf(fp, "\n  ]\n}\n");
+
+    if (fclose(fp) != 0) {
+        perror("instrumentation.json");
+        return 1;
+    }
+    return 0;
+}
+#endif
+
+// Usage:
+//   ./a.out [options]                          reads the number of processes from stdin
+//   ./a.out [options] --sweep <trials> <processes> [seed]
+//   ./a.out [options] --trace <file>           CSV (arrival,burst,priority[,io_burst...]) or binary workload
+//   ./a.out --generate <file> <processes> [seed]   writes a binary workload
+//   ./a.out [options] --bench [max_processes] [seed]  times every algorithm on generated workloads
+//   ./a.out [options] --what-if <base> <edited>...  re-schedules edited traces from checkpoints of one base run
+// smp options: --cpus <n>  --balance <steal|least-loaded|static>  --migration-cost <time>
+// --io <fcfs|sjf> gives generated processes an I/O burst and sets the device discipline
+// (traces always use their own I/O bursts; the device is FCFS unless --io says otherwise)
+// --dispatch-latency <time> and --switch-cost <time> charge every dispatch and context switch
+// --aging <interval> raises a waiting process's priority by one (SRTF: counts one unit less of its
+// remaining time) every interval under Preemptive Priority and Preemptive SJF
+// --results <csv|binary> also writes every process's results to process_results.csv / .bin
+// --chrome-trace <file> writes every algorithm's schedule as Chrome Trace Event JSON (interactive
+// and --trace runs), for chrome://tracing or ui.perfetto.dev
+// --verbosity <0-3> (--quiet is 0): 0 prints nothing, 1 the per-algorithm summary, 2 adds Gantt
+// charts, 3 (the default) also the workload and per-process times. Traces print the summary only.
+// Builds with -DINSTRUMENTATION=1 also write instrumentation.json next to scheduling_results.csv.
+int main(int argc, char* argv[]) {
+    SmpConfig smp_config = { 1, 0, &load_balancers[0] };
+    SimulationOptions options = { NULL, false, SELECT_ARRIVAL, 0, 0, 0, RESULTS_NONE, VERBOSITY_PROCESS, NULL };
+    int first = 1;
+    while (first < argc) {
+        if (strcmp(argv[first], "--quiet") == 0) {
+            options.verbosity = VERBOSITY_QUIET;
+            first++;
+            continue;
+        }
+        if (first + 1 == argc) {
+            break;
+        }
+        if (strcmp(argv[first], "--verbosity") == 0) {
+            options.verbosity = atoi(argv[first + 1]);
+            if (options.verbosity < VERBOSITY_QUIET || options.verbosity > VERBOSITY_PROCESS) {
+                printf("Usage: %s --verbosity <0-3>\n", argv[0]);
+                return 1;
+            }
+            first += 2;
+            continue;
+        }
+        if (strcmp(argv[first], "--dispatch-latency") == 0 || strcmp(argv[first], "--switch-cost") == 0) {
+            int cost = atoi(argv[first + 1]);
+            if (cost < 0) {
+                printf("Usage: %s --dispatch-latency <time> --switch-cost <time>\n", argv[0]);
+                return 1;
+            }
+            if (strcmp(argv[first], "--dispatch-latency") == 0) {
+                options.dispatch_latency = cost;
+            }
+            else {
+                options.switch_cost = cost;
+            }
+            first += 2;
+            continue;
+        }
+        if (strcmp(argv[first], "--results") == 0) {
+            if (strcmp(argv[first + 1], "csv") == 0) {
+                options.result_format = RESULTS_CSV;
+            }
+            else if (strcmp(argv[first + 1], "binary") == 0) {
+                options.result_format = RESULTS_BINARY;
+            }
+            else {
+                printf("Usage: %s --results <csv|binary>\n", argv[0]);
+                return 1;
+            }
+            first += 2;
+            continue;
+        }
+        if (strcmp(argv[first], "--aging") == 0) {
+            options.aging_interval = atoi(argv[first + 1]);
+            if (options.aging_interval < 0) {
+                printf("Usage: %s --aging <interval>\n", argv[0]);
+                return 1;
+            }
+            first += 2;
+            continue;
+        }
+        if (strcmp(argv[first], "--chrome-trace") == 0) {
+            options.chrome_trace = argv[first + 1];
+            first += 2;
+            continue;
+        }
+        if (strcmp(argv[first], "--io") == 0) {
+            options.with_io = true;
+            if (strcmp(argv[first + 1], "sjf") == 0) {
+                options.io_discipline = SELECT_IO_BURST;
+            }
+            else if (strcmp(argv[first + 1], "fcfs") != 0) {
+                printf("Usage: %s --io <fcfs|sjf>\n", argv[0]);
+                return 1;
+            }
+            first += 2;
+            continue;
+        }
+        if (strcmp(argv[first], "--cpus") == 0) {
+            smp_config.num_cpus = atoi(argv[first + 1]);
+        }
+        else if (strcmp(argv[first], "--balance") == 0) {
+            smp_config.balancer = find_load_balancer(argv[first + 1]);
+        }
+        else if (strcmp(argv[first], "--migration-cost") == 0) {
+            smp_config.migration_cost = atoi(argv[first + 1]);
+        }
+        else {
+            break;
+        }
+        options.smp = &smp_config;
+        first += 2;
+    }
+    if (options.smp != NULL && (smp_config.num_cpus <= 0 || smp_config.balancer == NULL || smp_config.migration_cost < 0)) {
+        printf("Usage: %s --cpus <n> --balance <steal|least-loaded|static> --migration-cost <time>\n", argv[0]);
+        return 1;
+    }
+    // drop the options, keeping the program name in argv[0]
+    argv[first - 1] = argv[0];
+    argv += first - 1;
+    argc -= first - 1;
+
+    if (argc >= 3 && strcmp(argv[1], "--trace") == 0) {
+        return run_trace(argv[2], &options);
+    }
+    if (argc >= 4 && strcmp(argv[1], "--what-if") == 0) {
+        return run_what_if(argv[2], &argv[3], argc - 3, &options);
+    }
+    if (argc >= 4 && strcmp(argv[1], "--generate") == 0) {
+        long long num_records = atoll(argv[3]);
+        uint64_t seed = (argc >= 5) ? strtoull(argv[4], NULL, 10) : (uint64_t)time(NULL);
+        if (num_records <= 0) {
+            printf("Usage: %s --generate <file> <processes> [seed]\n", argv[0]);
+            return 1;
+        }
+        return write_workload(argv[2], num_records, seed);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        long long max_processes = (argc >= 3) ? atoll(argv[2]) : BENCH_MAX_PROCESSES;
+        uint64_t seed = (argc >= 4) ? strtoull(argv[3], NULL, 10) : 1;
+        if (max_processes < 10 || max_processes > INT_MAX) {
+            printf("Usage: %s --bench [max_processes] [seed]\n", argv[0]);
+            return 1;
+        }
+        return run_benchmark(max_processes, seed, &options);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--sweep") == 0) {
+        int num_trials = (argc >= 3) ? atoi(argv[2]) : 0;
+        int num_processes = (argc >= 4) ? atoi(argv[3]) : 0;
+        uint64_t seed = (argc >= 5) ? strtoull(argv[4], NULL, 10) : (uint64_t)time(NULL);
+        if (num_trials <= 0 || num_processes <= 0) {
+            printf("Usage: %s --sweep <trials> <processes> [seed]\n", argv[0]);
+            return 1;
+        }
+        return run_sweep(num_trials, num_processes, seed, &options);
+    }
+
+    SimulationContext contexts[NUM_ALGORITHMS] = { 0 };
+    char* reports[NUM_ALGORITHMS] = { NULL };
+    size_t report_sizes[NUM_ALGORITHMS] = { 0 };
+    int num_processes;
+
+    if (scanf("%d", &num_processes) != 1 || num_processes <= 0) {
+        printf("Number of processes should be a positive integer.\n");
+        return 1;
+    }
+
+    Process* workload = grow_array(NULL, num_processes, sizeof(Process));
+    generate_processes(workload, num_processes, (uint64_t)time(NULL), options.with_io);
+    if (VERBOSE(options.verbosity, VERBOSITY_PROCESS)) {
+        print_processes(workload, num_processes);
+    }
+
+    // Every algorithm schedules its own copy of the workload and writes its report to memory
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        load_workload(&contexts[i], workload, num_processes);
+        apply_options(&contexts[i], &options);
+        contexts[i].trace_process = (options.chrome_trace != NULL) ? i + 1 : 0;
+        if (!VERBOSE(options.verbosity, VERBOSITY_SUMMARY)) {
+            continue;
+        }
+        contexts[i].out = open_memstream(&reports[i], &report_sizes[i]);
+        if (contexts[i].out == NULL) {
+            perror("Unable to open report stream");
+            return 1;
+        }
+    }
+
+    run_parallel(NUM_ALGORITHMS, default_thread_count(), run_algorithm_task, contexts);
+
+    // Reports and result rows are emitted in the fixed algorithm order
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        if (contexts[i].out != NULL) {
+            fclose(contexts[i].out);
+        }
+        if (reports[i] != NULL) {
+            fwrite(reports[i], 1, report_sizes[i], stdout);
+            free(reports[i]);
+        }
+    }
+    int status = write_results(contexts, NUM_ALGORITHMS, options.result_format);
+    if (options.chrome_trace != NULL && write_chrome_trace(options.chrome_trace, contexts, NUM_ALGORITHMS) != 0) {
+        status = 1;
+    }
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        free_simulation_context(&contexts[i]);
+    }
+
+    free(workload);
+    return status;
 }